@@ -1,5 +1,9 @@
 #include "ActorDB.h"
 #include "Helper.h"
+#include "ScriptWorkers.h"
+#include "CoroutineScheduler.h"
+#include "Timers.h"
+#include "InputHooks.h"
 
 
 
@@ -26,6 +30,7 @@ void ActorDB::setName(std::string name)
 void ActorDB::start() {
 
 	for (const auto& [key, component] : components) {
+		if (isParallel(key)) continue;
 		if (component["enabled"].isBool() && !component["enabled"]) continue;
 		if (!run || startComponents.count(key) != 0) {
 			if (component["OnStart"].isFunction()) {
@@ -51,6 +56,7 @@ void ActorDB::start() {
 
 void ActorDB::update() {
 	for (const auto& [key, component] : components) {
+		if (isParallel(key)) continue;
 		if (component["enabled"].isBool() && !component["enabled"]) continue;
 		if (component["OnUpdate"].isFunction()) {
 			try {
@@ -63,8 +69,24 @@ void ActorDB::update() {
 	}
 }
 
+void ActorDB::fixedUpdate() {
+	for (const auto& [key, component] : components) {
+		if (isParallel(key)) continue;
+		if (component["enabled"].isBool() && !component["enabled"]) continue;
+		if (component["OnFixedUpdate"].isFunction()) {
+			try {
+				component["OnFixedUpdate"](component);
+			}
+			catch (luabridge::LuaException const& e) {
+				ReportError(actor_name, e);
+			}
+		}
+	}
+}
+
 void ActorDB::lateUpdate() {
 	for (const auto& [key, component] : components) {
+		if (isParallel(key)) continue;
 		if (component["enabled"].isBool() && !component["enabled"]) continue;
 		if (component["OnLateUpdate"].isFunction()) {
 			try {
@@ -81,9 +103,13 @@ void ActorDB::lateUpdate() {
 }
 
 void ActorDB::Delete() {
+	CoroutineScheduler::StopOwnedBy(this);
+	Timers::ClearOwnedBy(this);
+	InputHooks::UnregisterAll(this);
 	for (const auto& [key, component] : components) {
 		if (key == bodyKey) { body->OnDestroy(); delete body; body = nullptr; continue; }
 		if (key == particleKey) {  delete particle; particle = nullptr; continue; }
+		if (isParallel(key)) { ScriptWorkers::Unregister(this, key); continue; }
 		if (component["OnDestroy"].isFunction()) {
 			try {
 				component["OnDestroy"](component);
@@ -154,10 +180,19 @@ void ActorDB::addComponent(const std::string& key, luabridge::LuaRef value) {
 	if (components.count(key) != 0) {
 		auto it = components.find(key);
 		it->second = value;
+		InputHooks::Unregister(this, key);
+		InputHooks::Register(this, key, value);
 		return;
 	}
 	startComponents.insert(key);
 	components.insert({ key,value });
+	InputHooks::Register(this, key, value);
+}
+
+void ActorDB::setParallel(const std::string& key) {
+	//Worker components can't take input callbacks, those run on the main state
+	parallelComponents.insert(key);
+	InputHooks::Unregister(this, key);
 }
 
 std::optional<luabridge::LuaRef*> ActorDB::componentExists(const std::string& key) {
@@ -207,12 +242,15 @@ void ActorDB::alterContainer() {
 	//Smth smth smth smth smth
 	for (std::pair<std::string, luabridge::LuaRef>& value : components_to_add) {
 		components.insert(value);
+		if (!isParallel(value.first)) InputHooks::Register(this, value.first, value.second);
 	}
 	components_to_add.clear();
 	for (std::string& value : components_to_remove) {
+		InputHooks::Unregister(this, value);
 		luabridge::LuaRef toBeDeleted = components.find(value)->second;
 		if (value == bodyKey) { body->OnDestroy(); components.erase(value); delete body; body = nullptr; continue; }
 		if (value == particleKey) { components.erase(value); delete particle; particle = nullptr; continue; }
+		if (isParallel(value)) { ScriptWorkers::Unregister(this, value); parallelComponents.erase(value); components.erase(value); continue; }
 		if (toBeDeleted["OnDestroy"].isFunction()) {
 			try {
 				toBeDeleted["OnDestroy"](toBeDeleted);
@@ -269,6 +307,10 @@ luabridge::LuaRef ActorDB::AddComponent(std::string type_name) {
 		componentInstance["type"] = type_name;
 		componentInstance["enabled"] = true;
 		componentInstance["actor"] = luabridge::LuaRef(lua_state, this);
+		if (ScriptWorkers::IsParallelType(type_name)) {
+			setParallel(componentKey);
+			ScriptWorkers::Register(this, componentKey, type_name, componentInstance);
+		}
 	}
 	//components.insert({ componentKey, componentInstance });
 	components_to_add.push_back({ componentKey, componentInstance });
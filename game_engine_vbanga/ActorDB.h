@@ -13,6 +13,8 @@
 #include "RigidBody.h"
 #include "ParticleSystem.h"
 
+void ReportError(const std::string& actor_name, const luabridge::LuaException& e);
+
 class ActorDB
 {
 private:
@@ -25,6 +27,7 @@ private:
 	std::vector<std::pair<std::string, luabridge::LuaRef>> components_to_add;
 	std::vector<std::string> components_to_remove;
 	std::unordered_set<std::string> startComponents;
+	std::unordered_set<std::string> parallelComponents; //Run on the script workers, not here
 	bool run = true;
 	bool toDelete = false;
 	bool persistent = false;
@@ -44,6 +47,7 @@ public:
 	std::string getName();
 	void start();
 	void update();
+	void fixedUpdate();
 	void lateUpdate();
 	void setKey(int);
 	static float getZoomFactor();
@@ -74,6 +78,8 @@ public:
 	void setRigidBody(RigidBody* value, std::string key) { body = value; bodyKey = key; }
 	void setParticleSystem(ParticleSystem* value, std::string key) { particle = value; particleKey = key; }
 	RigidBody* getRigidBody(){ return body;}
+	void setParallel(const std::string& key);
+	bool isParallel(const std::string& key) { return !parallelComponents.empty() && parallelComponents.count(key) != 0; }
 	/*void setCollider(bool val) { collider = val; }
 	bool getCollider() { return collider; }
 	void setTrigger(bool val) { trigger = val; }
@@ -0,0 +1,197 @@
+#include "AllocTracker.h"
+#include "Helper.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+std::atomic<uint64_t> AllocTracker::allocations[TAG_COUNT] = {};
+std::atomic<uint64_t> AllocTracker::bytes[TAG_COUNT] = {};
+std::atomic<uint64_t> AllocTracker::frees{ 0 };
+thread_local int AllocTracker::current_tag = AllocTracker::TAG_UNTAGGED;
+bool AllocTracker::enabled = false;
+bool AllocTracker::print_report = false;
+bool AllocTracker::steady_mode = false;
+std::atomic<bool> AllocTracker::steady_armed{ false };
+int AllocTracker::warmup_frames = 60;
+int AllocTracker::frames_since_reset = 0;
+uint64_t AllocTracker::frame_count = 0;
+uint64_t AllocTracker::last_allocations[TAG_COUNT] = {};
+uint64_t AllocTracker::last_bytes[TAG_COUNT] = {};
+AllocTracker::TagTotals AllocTracker::totals[TAG_COUNT];
+uint64_t AllocTracker::last_frame_allocations = 0;
+uint64_t AllocTracker::last_frame_bytes = 0;
+lua_Alloc AllocTracker::lua_allocator = nullptr;
+void* AllocTracker::lua_allocator_data = nullptr;
+
+const char* const AllocTracker::TAG_NAMES[TAG_COUNT] = {
+	"untagged", "lua", "scripts", "scene", "images", "text", "audio", "physics", "particles", "input", "render"
+};
+
+void AllocTracker::Init(bool for_bench) {
+	print_report = Helper::IsAllocTrackerMode();
+	if (enabled || !(print_report || for_bench)) {
+		return;
+	}
+	steady_mode = Helper::IsAllocTrackerSteadyMode();
+	warmup_frames = Helper::GetAllocTrackerWarmup();
+	enabled = true;
+}
+
+void AllocTracker::Shutdown() {
+	if (!enabled) return;
+	steady_armed = false;
+	EndFrame();
+	enabled = false;
+	if (!print_report) return;
+
+	uint64_t frames = std::max<uint64_t>(1, frame_count);
+	std::cout << "Allocation tracker: " << frame_count << " frames, " << frees.load() << " frees" << std::endl;
+	std::cout << "  " << std::left << std::setw(12) << "tag" << std::right << std::setw(12) << "allocs" << std::setw(14) << "bytes"
+		<< std::setw(12) << "allocs/fr" << std::setw(12) << "bytes/fr" << std::setw(12) << "peak allocs" << std::setw(14) << "peak bytes" << std::endl;
+	for (int tag = 0; tag < TAG_COUNT; tag++) {
+		const TagTotals& t = totals[tag];
+		if (t.allocations == 0) continue;
+		std::cout << "  " << std::left << std::setw(12) << TAG_NAMES[tag] << std::right << std::setw(12) << t.allocations << std::setw(14) << t.bytes
+			<< std::setw(12) << t.allocations / frames << std::setw(12) << t.bytes / frames
+			<< std::setw(12) << t.max_frame_allocations << std::setw(14) << t.max_frame_bytes << std::endl;
+	}
+}
+
+void AllocTracker::TrackLuaState(lua_State* L) {
+	if (!enabled) return;
+	void* ud = nullptr;
+	lua_Alloc current = lua_getallocf(L, &ud);
+	if (current == LuaAlloc) return;
+	//Every state comes from luaL_newstate, so they all share the one default allocator
+	lua_allocator = current;
+	lua_allocator_data = ud;
+	lua_setallocf(L, LuaAlloc, nullptr);
+}
+
+void* AllocTracker::LuaAlloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+	(void)ud;
+	if (nsize == 0) {
+		if (ptr) RecordFree();
+	}
+	else if (!ptr || nsize > osize) {
+		//For a fresh block osize holds the kind of object being created rather than a size
+		size_t grown = ptr ? nsize - osize : nsize;
+		int previous = current_tag;
+		current_tag = TAG_LUA;
+		Record(grown);
+		current_tag = previous;
+	}
+	return lua_allocator(lua_allocator_data, ptr, osize, nsize);
+}
+
+void AllocTracker::ResetWarmup() {
+	if (!enabled) return;
+	frames_since_reset = 0;
+	steady_armed = false;
+}
+
+void AllocTracker::EndFrame() {
+	if (!enabled) return;
+	frame_count++;
+
+	uint64_t frame_allocations = 0;
+	uint64_t frame_bytes = 0;
+	uint64_t tag_allocations[TAG_COUNT];
+	uint64_t tag_bytes[TAG_COUNT];
+	for (int tag = 0; tag < TAG_COUNT; tag++) {
+		uint64_t now_allocations = allocations[tag].load(std::memory_order_relaxed);
+		uint64_t now_bytes = bytes[tag].load(std::memory_order_relaxed);
+		tag_allocations[tag] = now_allocations - last_allocations[tag];
+		tag_bytes[tag] = now_bytes - last_bytes[tag];
+		last_allocations[tag] = now_allocations;
+		last_bytes[tag] = now_bytes;
+
+		TagTotals& t = totals[tag];
+		t.allocations += tag_allocations[tag];
+		t.bytes += tag_bytes[tag];
+		t.max_frame_allocations = std::max(t.max_frame_allocations, tag_allocations[tag]);
+		t.max_frame_bytes = std::max(t.max_frame_bytes, tag_bytes[tag]);
+		frame_allocations += tag_allocations[tag];
+		frame_bytes += tag_bytes[tag];
+	}
+	last_frame_allocations = frame_allocations;
+	last_frame_bytes = frame_bytes;
+
+	if (steady_armed && frame_allocations > 0) {
+		steady_armed = false;
+		std::cout << "error: " << frame_allocations << " allocations (" << frame_bytes << " bytes) in frame "
+			<< Helper::GetFrameNumber() << ", expected none after " << warmup_frames << " warmup frames" << std::endl;
+		for (int tag = 0; tag < TAG_COUNT; tag++) {
+			if (tag_allocations[tag] == 0) continue;
+			std::cout << "  " << TAG_NAMES[tag] << ": " << tag_allocations[tag] << " allocations, " << tag_bytes[tag] << " bytes" << std::endl;
+		}
+		exit(1);
+	}
+
+	if (steady_mode && ++frames_since_reset >= warmup_frames) {
+		steady_armed = true;
+	}
+}
+
+void AllocTracker::OnSteadyStateAllocation(size_t size) {
+	//Deliberately empty, set a breakpoint here to see what allocates during the steady state
+	(void)size;
+}
+
+//The replacements are always linked in, but only count once AllocTracker::Init has enabled them
+
+void* operator new(std::size_t size) {
+	AllocTracker::Record(size);
+	if (size == 0) size = 1;
+	while (true) {
+		if (void* p = std::malloc(size)) return p;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
+	}
+}
+
+void* operator new[](std::size_t size) {
+	return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return ::operator new(size);
+	}
+	catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept {
+	if (!ptr) return;
+	AllocTracker::RecordFree();
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	::operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+	::operator delete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	::operator delete(ptr);
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "lua/lua.hpp"
+
+//Opt-in heap allocation tracking, enabled by the ALLOCTRACKER environment variable.
+//The global operator new/delete are replaced (AllocTracker.cpp) and, once enabled, count every
+//allocation against the subsystem tag of the current thread, which ALLOC_SCOPE sets for the rest of
+//the enclosing block. Lua states get a counting allocator, so the Lua heap shows up as its own tag.
+//Jobs carry the tag of the code that submitted them. EndFrame() folds the counts into per-frame
+//figures and a per-tag table is printed on exit.
+//ALLOCTRACKER=steady also asserts a zero-allocation steady state: once ALLOCTRACKER_WARMUP frames
+//(default 60) have passed since the last scene load, a frame that allocates anything ends the run
+//with exit code 1 and a breakdown of what allocated. Break on AllocTracker::OnSteadyStateAllocation
+//to catch the allocation in a debugger.
+//Benchmark runs (--bench) switch the counting on without the report, see BenchReport.
+class AllocTracker
+{
+public:
+	enum Tag {
+		TAG_UNTAGGED,
+		TAG_LUA,
+		TAG_SCRIPTS,
+		TAG_SCENE,
+		TAG_IMAGES,
+		TAG_TEXT,
+		TAG_AUDIO,
+		TAG_PHYSICS,
+		TAG_PARTICLES,
+		TAG_INPUT,
+		TAG_RENDER,
+		TAG_COUNT
+	};
+	static const char* const TAG_NAMES[TAG_COUNT];
+
+	class Scope {
+		int previous;
+	public:
+		explicit Scope(Tag tag) : previous(current_tag) { current_tag = tag; }
+		~Scope() { current_tag = previous; }
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+private:
+	struct TagTotals {
+		uint64_t allocations = 0;
+		uint64_t bytes = 0;
+		uint64_t max_frame_allocations = 0;
+		uint64_t max_frame_bytes = 0;
+	};
+
+	static std::atomic<uint64_t> allocations[TAG_COUNT];
+	static std::atomic<uint64_t> bytes[TAG_COUNT];
+	static std::atomic<uint64_t> frees;
+	static thread_local int current_tag;
+	static bool enabled;
+	static bool print_report;
+	static bool steady_mode;
+	static std::atomic<bool> steady_armed;
+	static int warmup_frames;
+	static int frames_since_reset;
+	static uint64_t frame_count;
+	static uint64_t last_allocations[TAG_COUNT];
+	static uint64_t last_bytes[TAG_COUNT];
+	static TagTotals totals[TAG_COUNT];
+	static uint64_t last_frame_allocations;
+	static uint64_t last_frame_bytes;
+	static lua_Alloc lua_allocator;
+	static void* lua_allocator_data;
+
+	static void* LuaAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+public:
+	static void Init(bool for_bench = false);
+	static void Shutdown();
+	static bool IsEnabled() { return enabled; }
+	static void TrackLuaState(lua_State* L);
+	//Scene loads allocate freely, so the steady state check waits out another warmup after one
+	static void ResetWarmup();
+	static void EndFrame();
+	static uint64_t GetLastFrameAllocations() { return last_frame_allocations; }
+	static uint64_t GetLastFrameBytes() { return last_frame_bytes; }
+	static int GetCurrentTag() { return current_tag; }
+	static void SetCurrentTag(int tag) { current_tag = tag; }
+
+	//Called from operator new, do not allocate in here
+	static void Record(size_t size) {
+		if (!enabled) return;
+		int tag = current_tag;
+		allocations[tag].fetch_add(1, std::memory_order_relaxed);
+		bytes[tag].fetch_add(size, std::memory_order_relaxed);
+		if (steady_armed.load(std::memory_order_relaxed)) OnSteadyStateAllocation(size);
+	}
+	static void RecordFree() {
+		if (enabled) frees.fetch_add(1, std::memory_order_relaxed);
+	}
+	static void OnSteadyStateAllocation(size_t size);
+};
+
+#define ALLOC_CONCAT_INNER(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_INNER(a, b)
+#define ALLOC_SCOPE(tag) AllocTracker::Scope ALLOC_CONCAT(alloc_scope_, __LINE__)(AllocTracker::tag)
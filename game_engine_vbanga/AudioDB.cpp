@@ -1,4 +1,6 @@
 #include "AudioDB.h"
+#include "HitchDetector.h"
+#include "AllocTracker.h"
 
 std::unordered_map < std::string, Mix_Chunk* > AudioDB::audios;
 
@@ -11,15 +13,26 @@ void AudioDB::LoadAudio(const std::string& fileName) {
     }
 
     //Open The Song
+    ALLOC_SCOPE(TAG_AUDIO);
+    HitchDetector::CountAssetLoad();
     audios[fileName] = AudioHelper::Mix_LoadWAV((std::filesystem::exists(filePath + ".wav")) ? (filePath + ".wav").c_str() : (filePath + ".ogg").c_str());
 
 }
 
-void AudioDB::PlayAudio(int channel, std::string audioName, bool loop) {
+Mix_Chunk* AudioDB::GetAudio(const std::string& audioName) {
     if (!audios.count(audioName)) {
         LoadAudio(audioName);
     }
-    AudioHelper::Mix_PlayChannel(channel, audios[audioName],loop * -1);
+    return audios[audioName];
+}
+
+void AudioDB::PlayAudio(int channel, std::string audioName, bool loop) {
+    PlayChunk(channel, GetAudio(audioName), loop);
+}
+
+void AudioDB::PlayChunk(int channel, Mix_Chunk* chunk, bool loop) {
+    ALLOC_SCOPE(TAG_AUDIO);
+    AudioHelper::Mix_PlayChannel(channel, chunk, loop * -1);
 }
 
 void AudioDB::Halt(int channel) {
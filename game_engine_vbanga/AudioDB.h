@@ -12,7 +12,9 @@ private:
 	static std::unordered_map < std::string, Mix_Chunk* > audios;
 public:
 	static void LoadAudio(const std::string&);
+	static Mix_Chunk* GetAudio(const std::string&);
 	static void PlayAudio(int channel, std::string audioName, bool loop);
+	static void PlayChunk(int channel, Mix_Chunk* chunk, bool loop);
 	static void Halt(int channel);
 	static void SetVolume(int channel, float volume);
 };
@@ -0,0 +1,191 @@
+#include "BenchReport.h"
+#include "AllocTracker.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+bool BenchReport::enabled = false;
+std::string BenchReport::output_path;
+std::string BenchReport::source;
+lua_State* BenchReport::lua_state = nullptr;
+Uint64 BenchReport::last_frame_end = 0;
+double BenchReport::ticks_to_ms = 0.0;
+int BenchReport::frames = 0;
+std::vector<float> BenchReport::frame_ms;
+std::vector<uint64_t> BenchReport::frame_allocations;
+std::vector<uint64_t> BenchReport::frame_bytes;
+std::vector<BenchReport::SlowFrame> BenchReport::slowest;
+double BenchReport::lua_kb = 0.0;
+double BenchReport::lua_peak_kb = 0.0;
+size_t BenchReport::actors = 0;
+std::string BenchReport::final_frame_hash;
+int BenchReport::final_frame = -1;
+
+//Upper edges of the frame time histogram buckets, the last bucket takes everything slower
+const float HISTOGRAM_EDGES_MS[] = { 1.0f, 2.0f, 4.0f, 8.0f, 16.7f, 33.3f, 50.0f, 100.0f };
+const size_t HISTOGRAM_BUCKETS = sizeof(HISTOGRAM_EDGES_MS) / sizeof(HISTOGRAM_EDGES_MS[0]) + 1;
+
+void BenchReport::Init(const std::string& path, lua_State* L, int expected_frames) {
+	if (path.empty()) return;
+	output_path = path;
+	lua_state = L;
+	ticks_to_ms = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+	//Growing these mid-run would show up in the allocation counts being measured. Replays don't know
+	//their length up front, so they get room for a few minutes of frames.
+	size_t reserve = static_cast<size_t>(expected_frames > 0 ? expected_frames : 36000) + 1;
+	frame_ms.reserve(reserve);
+	frame_allocations.reserve(reserve);
+	frame_bytes.reserve(reserve);
+	slowest.reserve(SLOWEST_FRAMES + 1);
+	enabled = true;
+}
+
+void BenchReport::Start() {
+	last_frame_end = SDL_GetPerformanceCounter();
+}
+
+void BenchReport::EndFrame(int frame, size_t actor_count) {
+	if (!enabled) return;
+	Uint64 now = SDL_GetPerformanceCounter();
+	double kb = static_cast<double>(lua_gc(lua_state, LUA_GCCOUNT, 0)) + lua_gc(lua_state, LUA_GCCOUNTB, 0) / 1024.0;
+	lua_kb = kb;
+	lua_peak_kb = std::max(lua_peak_kb, kb);
+	actors = actor_count;
+	if (++frames > WARMUP_FRAMES) {
+		float ms = static_cast<float>((now - last_frame_end) * ticks_to_ms);
+		frame_ms.push_back(ms);
+		frame_allocations.push_back(AllocTracker::GetLastFrameAllocations());
+		frame_bytes.push_back(AllocTracker::GetLastFrameBytes());
+
+		//Kept sorted slowest first, so the fastest of them is at the back
+		if (slowest.size() < SLOWEST_FRAMES || ms > slowest.back().frame_ms) {
+			SlowFrame slow;
+			slow.frame = frame;
+			slow.frame_ms = ms;
+			const float* phase_ms = HitchDetector::GetLastPhaseMs();
+			std::copy(phase_ms, phase_ms + HitchDetector::PHASE_COUNT, slow.phase_ms);
+			auto position = std::upper_bound(slowest.begin(), slowest.end(), slow,
+				[](const SlowFrame& a, const SlowFrame& b) { return a.frame_ms > b.frame_ms; });
+			slowest.insert(position, slow);
+			if (slowest.size() > SLOWEST_FRAMES) slowest.pop_back();
+		}
+	}
+	last_frame_end = now;
+}
+
+void BenchReport::CaptureFinalFrame(SDL_Renderer* renderer, int frame) {
+	if (!enabled || !renderer) return;
+	int width = 0;
+	int height = 0;
+	if (SDL_GetRendererOutputSize(renderer, &width, &height) != 0) return;
+	std::vector<Uint8> pixels(static_cast<size_t>(width) * height * 4);
+	if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGBA32, pixels.data(), width * 4) != 0) {
+		SDL_Log("SDL_RenderReadPixels() failed: %s", SDL_GetError());
+		return;
+	}
+	//FNV-1a, enough to tell whether two runs ended on the same picture
+	uint64_t hash = 14695981039346656037ull;
+	for (Uint8 byte : pixels) {
+		hash = (hash ^ byte) * 1099511628211ull;
+	}
+	char text[17];
+	std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+	final_frame_hash = text;
+	final_frame = frame;
+}
+
+void BenchReport::Write() {
+	if (!enabled) return;
+	enabled = false;
+
+	size_t measured = frame_ms.size();
+	double mean_ms = 0.0, p50_ms = 0.0, p90_ms = 0.0, p95_ms = 0.0, p99_ms = 0.0, max_ms = 0.0;
+	double allocations_per_frame = 0.0, bytes_per_frame = 0.0;
+	uint64_t max_frame_allocations = 0;
+	size_t histogram[HISTOGRAM_BUCKETS] = {};
+	if (measured > 0) {
+		for (size_t i = 0; i < measured; i++) {
+			mean_ms += frame_ms[i];
+			allocations_per_frame += static_cast<double>(frame_allocations[i]);
+			bytes_per_frame += static_cast<double>(frame_bytes[i]);
+			max_frame_allocations = std::max(max_frame_allocations, frame_allocations[i]);
+			histogram[std::upper_bound(std::begin(HISTOGRAM_EDGES_MS), std::end(HISTOGRAM_EDGES_MS), frame_ms[i]) - std::begin(HISTOGRAM_EDGES_MS)]++;
+		}
+		mean_ms /= measured;
+		allocations_per_frame /= measured;
+		bytes_per_frame /= measured;
+		std::vector<float> sorted = frame_ms;
+		std::sort(sorted.begin(), sorted.end());
+		auto percentile = [&](double p) { return sorted[std::min(measured - 1, static_cast<size_t>(measured * p))]; };
+		p50_ms = sorted[(measured - 1) / 2];
+		p90_ms = percentile(0.90);
+		p95_ms = percentile(0.95);
+		p99_ms = percentile(0.99);
+		max_ms = sorted.back();
+	}
+
+	FILE* file = std::fopen(output_path.c_str(), "w");
+	if (!file) {
+		std::cerr << "Error : Failed to open " << output_path << " for writing." << std::endl;
+		return;
+	}
+	std::fprintf(file, "{\n");
+	if (!source.empty()) {
+		std::string escaped;
+		for (char c : source) {
+			if (c == '"' || c == '\\') escaped += '\\';
+			escaped += c;
+		}
+		std::fprintf(file, "  \"source\": \"%s\",\n", escaped.c_str());
+	}
+	std::fprintf(file,
+		"  \"frames\": %d,\n"
+		"  \"measured_frames\": %zu,\n"
+		"  \"mean_ms\": %.4f,\n"
+		"  \"p50_ms\": %.4f,\n"
+		"  \"p90_ms\": %.4f,\n"
+		"  \"p95_ms\": %.4f,\n"
+		"  \"p99_ms\": %.4f,\n"
+		"  \"max_ms\": %.4f,\n"
+		"  \"allocations_per_frame\": %.2f,\n"
+		"  \"bytes_per_frame\": %.1f,\n"
+		"  \"max_frame_allocations\": %llu,\n"
+		"  \"lua_kb\": %.1f,\n"
+		"  \"lua_peak_kb\": %.1f,\n"
+		"  \"actors\": %zu,\n",
+		frames, measured, mean_ms, p50_ms, p90_ms, p95_ms, p99_ms, max_ms, allocations_per_frame, bytes_per_frame,
+		static_cast<unsigned long long>(max_frame_allocations), lua_kb, lua_peak_kb, actors);
+
+	std::fprintf(file, "  \"histogram_ms\": [");
+	for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+		if (bucket + 1 < HISTOGRAM_BUCKETS) {
+			std::fprintf(file, "%s{ \"below\": %.1f, \"frames\": %zu }", bucket == 0 ? "" : ", ", HISTOGRAM_EDGES_MS[bucket], histogram[bucket]);
+		}
+		else {
+			std::fprintf(file, ", { \"below\": null, \"frames\": %zu }", histogram[bucket]);
+		}
+	}
+	std::fprintf(file, "],\n  \"slowest_frames\": [");
+	for (size_t i = 0; i < slowest.size(); i++) {
+		std::fprintf(file, "%s\n    { \"frame\": %d, \"ms\": %.3f, \"phases_ms\": {", i == 0 ? "" : ",", slowest[i].frame, slowest[i].frame_ms);
+		for (int phase = 0; phase < HitchDetector::PHASE_COUNT; phase++) {
+			std::fprintf(file, "%s\"%s\": %.3f", phase == 0 ? " " : ", ", HitchDetector::PHASE_NAMES[phase], slowest[i].phase_ms[phase]);
+		}
+		std::fprintf(file, " } }");
+	}
+	std::fprintf(file, "%s],\n", slowest.empty() ? "" : "\n  ");
+	if (final_frame_hash.empty()) {
+		std::fprintf(file, "  \"final_frame\": null,\n  \"final_frame_hash\": null\n}\n");
+	}
+	else {
+		std::fprintf(file, "  \"final_frame\": %d,\n  \"final_frame_hash\": \"%s\"\n}\n", final_frame, final_frame_hash.c_str());
+	}
+	std::fclose(file);
+
+	std::cout << "bench: " << measured << " frames measured, mean " << mean_ms << " ms, p50 " << p50_ms << " ms, p99 " << p99_ms
+		<< " ms, max " << max_ms << " ms";
+	if (!final_frame_hash.empty()) {
+		std::cout << ", final frame " << final_frame << " hash " << final_frame_hash;
+	}
+	std::cout << ", results in " << output_path << std::endl;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "SDL.h"
+#include "lua/lua.hpp"
+#include "HitchDetector.h"
+
+//Machine-readable results for benchmark runs, written when the engine is started with --bench <file>
+//or --replay-bench <file>. Every frame's time, allocation count (AllocTracker is switched on for the
+//run) and Lua heap size are recorded, and on exit the file gets one JSON object with the frame time
+//distribution (mean/p50/p90/p95/p99/max and a histogram), allocations and bytes per frame, the Lua
+//heap at the end and at its peak, the slowest frames with the time each phase of them took, and a
+//hash of the final frame's pixels when there is a renderer to read them back from. The first
+//WARMUP_FRAMES frames load the scene and warm caches, so they're left out of the frame statistics.
+//bench/stress_bench.cpp drives this over a suite of generated stress scenes; --replay-bench drives
+//it with a game's own input recording.
+class BenchReport
+{
+public:
+	static constexpr int WARMUP_FRAMES = 10;
+	static constexpr size_t SLOWEST_FRAMES = 10;
+private:
+	struct SlowFrame {
+		int frame = 0;
+		float frame_ms = 0.0f;
+		float phase_ms[HitchDetector::PHASE_COUNT] = {};
+	};
+
+	static bool enabled;
+	static std::string output_path;
+	static std::string source;
+	static lua_State* lua_state;
+	static Uint64 last_frame_end;
+	static double ticks_to_ms;
+	static int frames;
+	static std::vector<float> frame_ms;
+	static std::vector<uint64_t> frame_allocations;
+	static std::vector<uint64_t> frame_bytes;
+	static std::vector<SlowFrame> slowest;
+	static double lua_kb;
+	static double lua_peak_kb;
+	static size_t actors;
+	static std::string final_frame_hash;
+	static int final_frame;
+public:
+	static void Init(const std::string& path, lua_State* L, int expected_frames);
+	static bool IsEnabled() { return enabled; }
+	//What was run, e.g. the recording a replay benchmark played back
+	static void SetSource(const std::string& description) { source = description; }
+	static void Start();
+	static void EndFrame(int frame, size_t actor_count);
+	//Reads back and hashes what has been drawn so far; call it on the last frame, before presenting
+	static void CaptureFinalFrame(SDL_Renderer* renderer, int frame);
+	static void Write();
+};
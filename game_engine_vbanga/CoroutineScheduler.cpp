@@ -0,0 +1,228 @@
+#include "CoroutineScheduler.h"
+#include "ActorDB.h"
+#include "Helper.h"
+#include "SDL.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+lua_State* CoroutineScheduler::lua_state = nullptr;
+std::unordered_map<int, CoroutineScheduler::Coroutine> CoroutineScheduler::coroutines;
+std::unordered_map<lua_State*, int> CoroutineScheduler::thread_ids;
+int CoroutineScheduler::next_id = 1;
+ActorDB* CoroutineScheduler::current_owner = nullptr;
+std::unordered_map<const ActorDB*, std::vector<int>> CoroutineScheduler::owned_coroutines;
+
+//Frames are counted in frames, seconds in milliseconds
+TimingWheel<CoroutineScheduler::Waiter> CoroutineScheduler::frame_wheel;
+TimingWheel<CoroutineScheduler::Waiter> CoroutineScheduler::time_wheel;
+std::unordered_map<std::string, std::vector<CoroutineScheduler::Waiter>> CoroutineScheduler::event_waiters;
+std::vector<CoroutineScheduler::EventWakeup> CoroutineScheduler::event_wakeups;
+std::vector<CoroutineScheduler::Waiter> CoroutineScheduler::due;
+
+void CoroutineScheduler::Init(lua_State* L) {
+	lua_state = L;
+	//The wheels count from when the engine started, not from zero, so the first wait doesn't walk through the uptime
+	frame_wheel.Reset(static_cast<uint64_t>(Helper::GetFrameNumber()));
+	time_wheel.Reset(SDL_GetTicks());
+}
+
+int CoroutineScheduler::StartCoroutine(lua_State* L) {
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	int nargs = lua_gettop(L) - 1;
+
+	lua_State* thread = lua_newthread(L);
+	int thread_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	//The function and its arguments are the whole stack, move them onto the new thread
+	lua_xmove(L, thread, nargs + 1);
+
+	int id = next_id++;
+	Coroutine coroutine;
+	coroutine.thread = thread;
+	coroutine.thread_ref = thread_ref;
+	coroutine.owner = current_owner;
+	coroutines.emplace(id, coroutine);
+	thread_ids[thread] = id;
+	if (coroutine.owner) {
+		owned_coroutines[coroutine.owner].push_back(id);
+	}
+
+	//Like a normal call, the body runs right away up to its first wait
+	Resume(id, L, nargs);
+
+	lua_pushinteger(L, id);
+	return 1;
+}
+
+int CoroutineScheduler::StopCoroutine(lua_State* L) {
+	int id = static_cast<int>(luaL_checkinteger(L, 1));
+	auto it = coroutines.find(id);
+	if (it != coroutines.end()) {
+		it->second.stopped = true;
+		Finish(id);
+	}
+	return 0;
+}
+
+CoroutineScheduler::Coroutine* CoroutineScheduler::BeginWait(lua_State* L, const char* function_name) {
+	auto it = thread_ids.find(L);
+	if (it == thread_ids.end()) {
+		luaL_error(L, "%s can only be called from a coroutine started with Application.StartCoroutine", function_name);
+	}
+	if (!lua_isyieldable(L)) {
+		luaL_error(L, "%s cannot wait from inside an engine callback", function_name);
+	}
+	Coroutine& coroutine = coroutines[it->second];
+	coroutine.wait_token++;
+	coroutine.waiting = true;
+	return &coroutine;
+}
+
+int CoroutineScheduler::WaitFrames(lua_State* L) {
+	lua_Integer frames = luaL_optinteger(L, 1, 1);
+	Coroutine* coroutine = BeginWait(L, "WaitFrames");
+	uint64_t now = static_cast<uint64_t>(Helper::GetFrameNumber());
+	frame_wheel.SkipIdle(now);
+	frame_wheel.Schedule(now + static_cast<uint64_t>(std::max<lua_Integer>(frames, 1)),
+		{ thread_ids[L], coroutine->wait_token });
+	return lua_yield(L, 0);
+}
+
+int CoroutineScheduler::WaitSeconds(lua_State* L) {
+	lua_Number seconds = luaL_checknumber(L, 1);
+	Coroutine* coroutine = BeginWait(L, "WaitSeconds");
+	uint64_t delay = seconds > 0 ? static_cast<uint64_t>(std::llround(seconds * 1000.0)) : 0;
+	uint64_t now = SDL_GetTicks();
+	time_wheel.SkipIdle(now);
+	time_wheel.Schedule(now + delay, { thread_ids[L], coroutine->wait_token });
+	return lua_yield(L, 0);
+}
+
+int CoroutineScheduler::WaitForEvent(lua_State* L) {
+	const char* type = luaL_checkstring(L, 1);
+	Coroutine* coroutine = BeginWait(L, "WaitForEvent");
+	event_waiters[type].push_back({ thread_ids[L], coroutine->wait_token });
+	return lua_yield(L, 0);
+}
+
+bool CoroutineScheduler::IsCurrent(const Waiter& waiter) {
+	auto it = coroutines.find(waiter.id);
+	if (it == coroutines.end()) return false;
+	const Coroutine& coroutine = it->second;
+	return coroutine.waiting && !coroutine.stopped && coroutine.wait_token == waiter.wait_token;
+}
+
+void CoroutineScheduler::OnEvent(const std::string& type, luabridge::LuaRef event_object) {
+	auto it = event_waiters.find(type);
+	if (it == event_waiters.end()) return;
+	std::vector<Waiter> waiters = std::move(it->second);
+	event_waiters.erase(it);
+
+	//Resumed from Tick rather than here, so a publish never re-enters a running coroutine
+	for (const Waiter& waiter : waiters) {
+		if (!IsCurrent(waiter)) continue;
+		event_object.push(lua_state);
+		event_wakeups.push_back({ waiter, luaL_ref(lua_state, LUA_REGISTRYINDEX) });
+	}
+}
+
+void CoroutineScheduler::Tick() {
+	//Waits left behind by stopped coroutines still have to be stepped past, or the wheels fall behind
+	if (coroutines.empty() && event_wakeups.empty() && frame_wheel.Empty() && time_wheel.Empty()) return;
+
+	due.clear();
+	frame_wheel.Advance(static_cast<uint64_t>(Helper::GetFrameNumber()), due);
+	time_wheel.Advance(SDL_GetTicks(), due);
+	for (size_t i = 0; i < due.size(); i++) {
+		if (IsCurrent(due[i])) Resume(due[i].id, lua_state, 0);
+	}
+
+	if (event_wakeups.empty()) return;
+	std::vector<EventWakeup> wakeups;
+	wakeups.swap(event_wakeups);
+	for (const EventWakeup& wakeup : wakeups) {
+		if (IsCurrent(wakeup.waiter)) {
+			//WaitForEvent returns the event object
+			lua_State* thread = coroutines[wakeup.waiter.id].thread;
+			lua_rawgeti(thread, LUA_REGISTRYINDEX, wakeup.event_ref);
+			Resume(wakeup.waiter.id, lua_state, 1);
+		}
+		luaL_unref(lua_state, LUA_REGISTRYINDEX, wakeup.event_ref);
+	}
+}
+
+void CoroutineScheduler::Resume(int id, lua_State* from, int nargs) {
+	//Map nodes don't move, so this stays valid even if the body starts more coroutines
+	Coroutine& coroutine = coroutines[id];
+	coroutine.waiting = false;
+	coroutine.running = true;
+
+	ActorDB* previous_owner = current_owner;
+	current_owner = coroutine.owner;
+	int nresults = 0;
+	int status = lua_resume(coroutine.thread, from, nargs, &nresults);
+	current_owner = previous_owner;
+	coroutine.running = false;
+
+	if (status == LUA_YIELD) {
+		lua_pop(coroutine.thread, nresults);
+		if (coroutine.stopped) {
+			Finish(id);
+		}
+		else if (!coroutine.waiting) {
+			//A bare coroutine.yield() waits a single frame
+			coroutine.wait_token++;
+			coroutine.waiting = true;
+			frame_wheel.Schedule(static_cast<uint64_t>(Helper::GetFrameNumber()) + 1, { id, coroutine.wait_token });
+		}
+		return;
+	}
+
+	if (status != LUA_OK) {
+		const char* message = lua_tostring(coroutine.thread, -1);
+		luaL_traceback(lua_state, coroutine.thread, message ? message : "error object is not a string", 0);
+		std::string error_message = lua_tostring(lua_state, -1);
+		lua_pop(lua_state, 1);
+		std::replace(error_message.begin(), error_message.end(), '\\', '/');
+		std::string name = coroutine.owner ? coroutine.owner->getName() : "coroutine";
+		std::cout << "\033[31m" << name << " : " << error_message << "\033[0m" << std::endl;
+	}
+	Finish(id);
+}
+
+void CoroutineScheduler::Finish(int id) {
+	auto it = coroutines.find(id);
+	if (it == coroutines.end()) return;
+	//A coroutine stopping itself is cleaned up once it yields back to Resume
+	if (it->second.running) {
+		it->second.stopped = true;
+		return;
+	}
+	thread_ids.erase(it->second.thread);
+	luaL_unref(lua_state, LUA_REGISTRYINDEX, it->second.thread_ref);
+	auto owned = owned_coroutines.find(it->second.owner);
+	if (owned != owned_coroutines.end()) {
+		std::vector<int>& ids = owned->second;
+		auto position = std::find(ids.begin(), ids.end(), id);
+		if (position != ids.end()) {
+			*position = ids.back();
+			ids.pop_back();
+		}
+		if (ids.empty()) owned_coroutines.erase(owned);
+	}
+	coroutines.erase(it);
+}
+
+void CoroutineScheduler::StopOwnedBy(const ActorDB* owner) {
+	auto owned = owned_coroutines.find(owner);
+	if (owned == owned_coroutines.end()) return;
+	//Taken out of the index first, since Finish takes each one out of it as well
+	std::vector<int> ids = std::move(owned->second);
+	owned_coroutines.erase(owned);
+	for (int id : ids) {
+		auto it = coroutines.find(id);
+		if (it == coroutines.end()) continue;
+		it->second.stopped = true;
+		Finish(id);
+	}
+}
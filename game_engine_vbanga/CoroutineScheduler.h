@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "lua/lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+#include "TimingWheel.h"
+
+class ActorDB;
+
+//Engine-side coroutines for component scripts. Application.StartCoroutine(fn, ...) runs fn on its
+//own Lua thread until it waits, and the waits park it in a timing wheel (frames or milliseconds) or
+//on an event type. Tick() only resumes the coroutines that are due, so a waiting coroutine costs
+//nothing per frame. A coroutine belongs to the actor whose callback started it and is stopped
+//when that actor is destroyed.
+class CoroutineScheduler
+{
+private:
+	struct Coroutine {
+		lua_State* thread = nullptr;
+		int thread_ref = LUA_NOREF;
+		ActorDB* owner = nullptr;
+		unsigned int wait_token = 0; //Bumped on every wait so stale wheel entries are ignored
+		bool waiting = false;
+		bool running = false;
+		bool stopped = false;
+	};
+
+	struct Waiter {
+		int id;
+		unsigned int wait_token;
+	};
+
+	struct EventWakeup {
+		Waiter waiter;
+		int event_ref;
+	};
+
+	static lua_State* lua_state;
+	static std::unordered_map<int, Coroutine> coroutines;
+	static std::unordered_map<lua_State*, int> thread_ids;
+	static int next_id;
+	static ActorDB* current_owner;
+	//Each actor's coroutines, so destroying an actor only touches its own
+	static std::unordered_map<const ActorDB*, std::vector<int>> owned_coroutines;
+
+	static TimingWheel<Waiter> frame_wheel;
+	static TimingWheel<Waiter> time_wheel;
+	static std::unordered_map<std::string, std::vector<Waiter>> event_waiters;
+	static std::vector<EventWakeup> event_wakeups;
+	static std::vector<Waiter> due;
+
+	static void Resume(int id, lua_State* from, int nargs);
+	static void Finish(int id);
+	static Coroutine* BeginWait(lua_State* L, const char* function_name);
+	static bool IsCurrent(const Waiter& waiter);
+public:
+	static void Init(lua_State* L);
+	static void Tick();
+	static void SetOwner(ActorDB* owner) { current_owner = owner; }
+	static ActorDB* GetOwner() { return current_owner; }
+	static void StopOwnedBy(const ActorDB* owner);
+	static void OnEvent(const std::string& type, luabridge::LuaRef event_object);
+	static bool HasEventWaiters() { return !event_waiters.empty(); }
+	static size_t GetCount() { return coroutines.size(); }
+
+	//Lua API, registered under Application
+	static int StartCoroutine(lua_State* L);
+	static int StopCoroutine(lua_State* L);
+	static int WaitFrames(lua_State* L);
+	static int WaitSeconds(lua_State* L);
+	static int WaitForEvent(lua_State* L);
+};
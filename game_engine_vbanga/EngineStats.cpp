@@ -0,0 +1,109 @@
+#include "EngineStats.h"
+#include "SceneDB.hpp"
+#include "ImageDB.h"
+#include "TextDB.h"
+#include "RigidBody.h"
+#include "ParticleSystem.h"
+#include "FramePacer.h"
+#include "Input.h"
+#include <cstdio>
+
+SceneDB* EngineStats::scene = nullptr;
+lua_State* EngineStats::lua_state = nullptr;
+size_t EngineStats::particles_last_frame = 0;
+std::string EngineStats::overlay_font;
+int EngineStats::overlay_font_size = 14;
+SDL_Scancode EngineStats::overlay_key = SDL_SCANCODE_F3;
+bool EngineStats::overlay_visible = false;
+
+void EngineStats::Init(SceneDB* scene_manager, lua_State* L) {
+	scene = scene_manager;
+	lua_state = L;
+}
+
+void EngineStats::ConfigureOverlay(const std::string& font_name, int font_size, const std::string& key) {
+	overlay_font = font_name;
+	overlay_font_size = font_size > 0 ? font_size : 14;
+	SDL_Scancode scancode = Input::GetScancode(key);
+	if (scancode == SDL_SCANCODE_UNKNOWN) {
+		std::cout << "error: unknown stats_overlay_key " << key;
+		exit(0);
+	}
+	overlay_key = scancode;
+}
+
+void EngineStats::EndFrame() {
+	//Particle systems count as they draw, so the total is only known once the frame's updates are done
+	particles_last_frame = ParticleSystem::takeLiveParticleCount();
+}
+
+EngineStats::Snapshot EngineStats::Collect() {
+	Snapshot stats;
+	stats.frame_ms = FramePacer::GetDeltaTime() * 1000.0;
+	stats.draw_calls = ImageDB::getLastDrawCalls();
+	stats.texture_switches = ImageDB::getLastTextureSwitches();
+	stats.text_textures = TextDB::getLastTextTextures();
+	if (scene) {
+		stats.actors = scene->getActorCount();
+		stats.components = scene->getComponentCount();
+	}
+	stats.bodies = RigidBody::getBodyCount();
+	stats.contacts = RigidBody::getContactCount();
+	stats.lua_kb = lua_state ? lua_gc(lua_state, LUA_GCCOUNT, 0) : 0;
+	stats.particles = particles_last_frame;
+	stats.texture_bytes = ImageDB::getTextureBytes();
+	return stats;
+}
+
+void EngineStats::UpdateOverlay() {
+	if (overlay_font.empty()) return;
+	if (Input::GetScancodeDown(overlay_key)) {
+		overlay_visible = !overlay_visible;
+	}
+	if (!overlay_visible) return;
+
+	Snapshot stats = Collect();
+	char lines[7][96];
+	std::snprintf(lines[0], sizeof(lines[0]), "frame %.2f ms", stats.frame_ms);
+	std::snprintf(lines[1], sizeof(lines[1]), "draws %d  texture switches %d  text %d", stats.draw_calls, stats.texture_switches, stats.text_textures);
+	std::snprintf(lines[2], sizeof(lines[2]), "actors %zu  components %zu", stats.actors, stats.components);
+	std::snprintf(lines[3], sizeof(lines[3]), "bodies %d  contacts %d", stats.bodies, stats.contacts);
+	std::snprintf(lines[4], sizeof(lines[4]), "particles %zu", stats.particles);
+	std::snprintf(lines[5], sizeof(lines[5]), "lua %d KB", stats.lua_kb);
+	std::snprintf(lines[6], sizeof(lines[6]), "textures %.1f MB", static_cast<double>(stats.texture_bytes) / (1024.0 * 1024.0));
+	int line_count = 7;
+
+	TTF_Font* font = TextDB::GetFont(overlay_font, overlay_font_size);
+	float line_height = static_cast<float>(overlay_font_size) * 1.25f;
+	for (int i = 0; i < line_count; i++) {
+		TextDB::DrawTextWithFont(lines[i], 8.0f, 8.0f + line_height * i, font, 255, 255, 255, 255);
+	}
+}
+
+int EngineStats::LuaGetStats(lua_State* L) {
+	Snapshot stats = Collect();
+	lua_createtable(L, 0, 11);
+	lua_pushnumber(L, stats.frame_ms);
+	lua_setfield(L, -2, "frame_ms");
+	lua_pushinteger(L, stats.draw_calls);
+	lua_setfield(L, -2, "draw_calls");
+	lua_pushinteger(L, stats.texture_switches);
+	lua_setfield(L, -2, "texture_switches");
+	lua_pushinteger(L, stats.text_textures);
+	lua_setfield(L, -2, "text_textures");
+	lua_pushinteger(L, static_cast<lua_Integer>(stats.actors));
+	lua_setfield(L, -2, "actors");
+	lua_pushinteger(L, static_cast<lua_Integer>(stats.components));
+	lua_setfield(L, -2, "components");
+	lua_pushinteger(L, stats.bodies);
+	lua_setfield(L, -2, "physics_bodies");
+	lua_pushinteger(L, stats.contacts);
+	lua_setfield(L, -2, "physics_contacts");
+	lua_pushinteger(L, stats.lua_kb);
+	lua_setfield(L, -2, "lua_kb");
+	lua_pushinteger(L, static_cast<lua_Integer>(stats.particles));
+	lua_setfield(L, -2, "particles");
+	lua_pushinteger(L, static_cast<lua_Integer>(stats.texture_bytes));
+	lua_setfield(L, -2, "texture_bytes");
+	return 1;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include "SDL.h"
+#include "lua/lua.hpp"
+
+class SceneDB;
+
+//Engine load figures for scripts (Application.GetStats()) and for a built-in overlay.
+//Render-side counts (draw calls, texture switches, text textures) are for the last frame
+//ImageDB::RenderAll drew; the rest are sampled when asked for. The overlay is toggled with
+//"stats_overlay_key" (f3 by default) and is drawn with TextDB in "stats_overlay_font", so it
+//is only available once a font is configured.
+class EngineStats
+{
+public:
+	struct Snapshot {
+		double frame_ms = 0.0;
+		int draw_calls = 0;
+		int texture_switches = 0;
+		int text_textures = 0;
+		size_t actors = 0;
+		size_t components = 0;
+		int bodies = 0;
+		int contacts = 0;
+		int lua_kb = 0;
+		size_t particles = 0;
+		size_t texture_bytes = 0;
+	};
+private:
+	static SceneDB* scene;
+	static lua_State* lua_state;
+	static size_t particles_last_frame;
+	static std::string overlay_font;
+	static int overlay_font_size;
+	static SDL_Scancode overlay_key;
+	static bool overlay_visible;
+public:
+	static void Init(SceneDB* scene_manager, lua_State* L);
+	static void ConfigureOverlay(const std::string& font_name, int font_size, const std::string& key);
+	static void EndFrame();
+	static Snapshot Collect();
+	static void UpdateOverlay();
+
+	//Lua API, registered under Application
+	static int LuaGetStats(lua_State* L);
+};
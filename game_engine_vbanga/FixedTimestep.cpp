@@ -0,0 +1,42 @@
+#include "FixedTimestep.h"
+#include "FramePacer.h"
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+
+double FixedTimestep::step_seconds = 1.0 / 60.0;
+int FixedTimestep::max_substeps = 5;
+double FixedTimestep::accumulator = 0.0;
+float FixedTimestep::alpha = 0.0f;
+
+void FixedTimestep::Configure(double tick_rate, int substep_limit) {
+	if (tick_rate <= 0.0) {
+		std::cout << "error: fixed_tick_rate must be positive";
+		exit(0);
+	}
+	step_seconds = 1.0 / tick_rate;
+	max_substeps = std::max(1, substep_limit);
+	accumulator = 0.0;
+}
+
+int FixedTimestep::BeginFrame() {
+	double frame_seconds = FramePacer::GetDeltaTime();
+	accumulator += frame_seconds;
+	int ticks = static_cast<int>(accumulator / step_seconds);
+	if (ticks > max_substeps) {
+		//Drop the time we can't catch up on; the simulation runs slow instead of falling further behind
+		ticks = max_substeps;
+		accumulator = std::fmod(accumulator, step_seconds);
+	}
+	else {
+		accumulator -= ticks * step_seconds;
+	}
+	alpha = static_cast<float>(std::clamp(accumulator / step_seconds, 0.0, 1.0));
+	return ticks;
+}
+
+int FixedTimestep::GetFixedDeltaTime(lua_State* L) {
+	lua_pushnumber(L, step_seconds);
+	return 1;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "lua/lua.hpp"
+
+//Accumulator for the fixed-rate part of the frame (OnFixedUpdate and the physics step). Each
+//rendered frame adds its real duration, and as many whole ticks as that covers are run, capped at
+//max_substeps so one slow frame can't snowball into a spiral of catch-up ticks. Whatever is left
+//over becomes the interpolation alpha renderers use to blend the last two physics states.
+//Frame durations come from FramePacer, so reproducible runs get the same ticks every time.
+class FixedTimestep
+{
+private:
+	static double step_seconds;
+	static int max_substeps;
+	static double accumulator;
+	static float alpha;
+public:
+	static void Configure(double tick_rate, int substep_limit);
+	static int BeginFrame();
+	static double GetStep() { return step_seconds; }
+	static float GetAlpha() { return alpha; }
+
+	//Lua API, registered under Application
+	static int GetFixedDeltaTime(lua_State* L);
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "SDL.h"
+
+//Opt-in frame capture. The main thread only reads the presented frame back into one of a small
+//ring of staging buffers; encoding and disk writes happen on worker threads, which hand the buffer
+//back to the ring when they're done. If every buffer is still in flight the main thread waits for
+//one rather than dropping a frame, so a captured run is always complete.
+class FrameCapture
+{
+public:
+	enum Format { FORMAT_QOI, FORMAT_BMP };
+private:
+	struct CaptureJob {
+		int buffer;
+		int frame;
+	};
+
+	static bool enabled;
+	static Format format;
+	static int interval;
+	static int width;
+	static int height;
+	static int pitch;
+	static std::string directory;
+
+	static std::vector<std::vector<Uint8>> staging_buffers;
+	static std::vector<int> free_buffers;
+	static std::deque<CaptureJob> jobs;
+	static std::vector<std::thread> threads;
+	static std::mutex capture_mutex;
+	static std::condition_variable job_ready;
+	static std::condition_variable buffer_free;
+	static bool stopping;
+
+	static void WorkerLoop();
+	static void Encode(const CaptureJob& job, std::vector<Uint8>& scratch);
+	static void EncodeQOI(const Uint8* pixels, std::vector<Uint8>& out);
+public:
+	static void Init(SDL_Renderer* renderer, const std::string& frame_directory, Format capture_format, int capture_interval);
+	static void Shutdown();
+	static bool IsEnabled() { return enabled; }
+	static void Capture(SDL_Renderer* renderer, int frame_number);
+};
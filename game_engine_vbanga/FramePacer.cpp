@@ -0,0 +1,76 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <thread>
+
+double FramePacer::target_fps = 60.0;
+Uint64 FramePacer::frequency = 1;
+Uint64 FramePacer::period_ticks = 0;
+Uint64 FramePacer::deadline = 0;
+Uint64 FramePacer::last_frame_end = 0;
+Uint64 FramePacer::start_counter = 0;
+std::atomic<double> FramePacer::delta_time(1.0 / 60.0);
+std::atomic<double> FramePacer::elapsed_time(0.0);
+
+//What a frame is worth in reproducible runs, and before the first one has been measured
+const double DETERMINISTIC_FRAME_SECONDS = 1.0 / 60.0;
+//SDL_Delay is trusted up to this close to the deadline; the rest is spent spinning
+const double SPIN_MARGIN_SECONDS = 0.002;
+
+void FramePacer::Configure(double fps) {
+	//0 (or less) means uncapped
+	target_fps = std::max(0.0, fps);
+	frequency = SDL_GetPerformanceFrequency();
+	period_ticks = target_fps > 0.0 ? static_cast<Uint64>(static_cast<double>(frequency) / target_fps) : 0;
+}
+
+void FramePacer::Start() {
+	start_counter = SDL_GetPerformanceCounter();
+	last_frame_end = start_counter;
+	deadline = start_counter + period_ticks;
+	delta_time = DETERMINISTIC_FRAME_SECONDS;
+	elapsed_time = 0.0;
+}
+
+void FramePacer::EndFrame(bool deterministic) {
+	Uint64 now = SDL_GetPerformanceCounter();
+
+	if (!deterministic && period_ticks > 0) {
+		if (now < deadline) {
+			double remaining = static_cast<double>(deadline - now) / static_cast<double>(frequency);
+			if (remaining > SPIN_MARGIN_SECONDS) {
+				SDL_Delay(static_cast<Uint32>((remaining - SPIN_MARGIN_SECONDS) * 1000.0));
+			}
+			while ((now = SDL_GetPerformanceCounter()) < deadline) {
+				std::this_thread::yield();
+			}
+			deadline += period_ticks;
+		}
+		else if (now - deadline > period_ticks) {
+			//More than a whole frame late: start over from now rather than rushing to catch up
+			deadline = now + period_ticks;
+		}
+		else {
+			deadline += period_ticks;
+		}
+	}
+
+	if (deterministic) {
+		delta_time = DETERMINISTIC_FRAME_SECONDS;
+		elapsed_time = elapsed_time + DETERMINISTIC_FRAME_SECONDS;
+	}
+	else {
+		delta_time = static_cast<double>(now - last_frame_end) / static_cast<double>(frequency);
+		elapsed_time = static_cast<double>(now - start_counter) / static_cast<double>(frequency);
+	}
+	last_frame_end = now;
+}
+
+int FramePacer::LuaGetDeltaTime(lua_State* L) {
+	lua_pushnumber(L, delta_time);
+	return 1;
+}
+
+int FramePacer::LuaGetTime(lua_State* L) {
+	lua_pushnumber(L, elapsed_time);
+	return 1;
+}
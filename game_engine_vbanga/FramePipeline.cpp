@@ -0,0 +1,129 @@
+#include "FramePipeline.h"
+#include <future>
+#include "Profiler.h"
+
+FramePipeline::SimulateFunction FramePipeline::simulate;
+std::thread* FramePipeline::sim_thread = nullptr;
+std::thread::id FramePipeline::render_thread_id;
+std::mutex FramePipeline::pipeline_mutex;
+std::condition_variable FramePipeline::sim_start;
+std::condition_variable FramePipeline::sim_finished;
+std::condition_variable FramePipeline::task_finished;
+std::deque<std::function<void()>*> FramePipeline::render_tasks;
+std::vector<SDL_Event> FramePipeline::frame_events;
+size_t FramePipeline::tasks_completed = 0;
+bool FramePipeline::frame_pending = false;
+bool FramePipeline::sim_busy = false;
+bool FramePipeline::stopping = false;
+bool FramePipeline::running = false;
+bool FramePipeline::quit_requested = false;
+
+void FramePipeline::Start(SimulateFunction simulate_frame) {
+	if (running) return;
+	simulate = std::move(simulate_frame);
+	render_thread_id = std::this_thread::get_id();
+	stopping = false;
+	running = true;
+	sim_thread = new std::thread(&FramePipeline::SimLoop);
+}
+
+void FramePipeline::Stop() {
+	if (!running) return;
+	if (std::this_thread::get_id() != render_thread_id) {
+		//exit() from the simulation thread, which can't join itself. Instead the main thread is parked for
+		//good at the frame boundary, on a lock that's leaked like sim_thread, so static destruction
+		//doesn't pull it out from under the main thread
+		struct Park {
+			std::mutex hold;
+			std::promise<void> reached;
+		};
+		Park* park = new Park();
+		park->hold.lock();
+		std::future<void> reached = park->reached.get_future();
+		{
+			std::lock_guard<std::mutex> lock(pipeline_mutex);
+			render_tasks.push_back(new std::function<void()>([park] {
+				park->reached.set_value();
+				park->hold.lock();
+			}));
+		}
+		sim_finished.notify_one();
+		reached.wait();
+		return;
+	}
+	WaitForFrame();
+	{
+		std::lock_guard<std::mutex> lock(pipeline_mutex);
+		stopping = true;
+	}
+	sim_start.notify_one();
+	sim_thread->join();
+	delete sim_thread;
+	sim_thread = nullptr;
+	running = false;
+}
+
+void FramePipeline::BeginFrame(std::vector<SDL_Event>& events) {
+	{
+		std::lock_guard<std::mutex> lock(pipeline_mutex);
+		frame_events.swap(events);
+		frame_pending = true;
+		sim_busy = true;
+	}
+	sim_start.notify_one();
+}
+
+void FramePipeline::WaitForFrame() {
+	std::unique_lock<std::mutex> lock(pipeline_mutex);
+	while (true) {
+		sim_finished.wait(lock, [] { return !sim_busy || !render_tasks.empty(); });
+		while (!render_tasks.empty()) {
+			std::function<void()>* task = render_tasks.front();
+			render_tasks.pop_front();
+			lock.unlock();
+			(*task)();
+			lock.lock();
+			tasks_completed++;
+			task_finished.notify_all();
+		}
+		if (!sim_busy) return;
+	}
+}
+
+void FramePipeline::RunOnRenderThread(const std::function<void()>& task) {
+	if (!running || std::this_thread::get_id() == render_thread_id) {
+		task();
+		return;
+	}
+
+	//Only the simulation thread gets here, and it waits for its own task, so there is one in flight at most
+	std::function<void()> pending = task;
+	std::unique_lock<std::mutex> lock(pipeline_mutex);
+	size_t ticket = tasks_completed + render_tasks.size() + 1;
+	render_tasks.push_back(&pending);
+	sim_finished.notify_one();
+	task_finished.wait(lock, [ticket] { return tasks_completed >= ticket; });
+}
+
+void FramePipeline::SimLoop() {
+	Profiler::SetThreadName("simulation");
+	std::vector<SDL_Event> events;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(pipeline_mutex);
+			sim_start.wait(lock, [] { return stopping || frame_pending; });
+			if (stopping) return;
+			frame_pending = false;
+			events.swap(frame_events);
+		}
+
+		simulate(events);
+		events.clear();
+
+		{
+			std::lock_guard<std::mutex> lock(pipeline_mutex);
+			sim_busy = false;
+		}
+		sim_finished.notify_one();
+	}
+}
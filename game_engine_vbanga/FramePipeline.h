@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "SDL.h"
+
+//Runs the simulation half of each frame (input, scripts, physics) on its own thread so that it
+//overlaps with the main thread rendering and presenting the previous frame. The threads meet once
+//per frame at a boundary where the finished draw lists are handed over and the next frame's input
+//is passed in; nothing else is shared while both are running.
+//SDL's renderer may only be used from the thread that created it, so anything the simulation needs
+//the renderer for (creating textures, cursor changes) goes through RunOnRenderThread, which the main
+//thread services while it waits at the boundary.
+class FramePipeline
+{
+public:
+	using SimulateFunction = std::function<void(const std::vector<SDL_Event>&)>;
+private:
+	static SimulateFunction simulate;
+	//Heap allocated: the engine's error paths call exit() from script code, which can be on the
+	//simulation thread, and destroying a joinable std::thread at exit would abort the process
+	static std::thread* sim_thread;
+	static std::thread::id render_thread_id;
+	static std::mutex pipeline_mutex;
+	static std::condition_variable sim_start;
+	static std::condition_variable sim_finished;
+	static std::condition_variable task_finished;
+	static std::deque<std::function<void()>*> render_tasks;
+	static std::vector<SDL_Event> frame_events;
+	static size_t tasks_completed;
+	static bool frame_pending;
+	static bool sim_busy;
+	static bool stopping;
+	static bool running;
+	static bool quit_requested;
+
+	static void SimLoop();
+public:
+	static void Start(SimulateFunction simulate_frame);
+	//Either thread may call this; the simulation thread can't join itself, so from there it parks
+	//the main thread at the frame boundary for the rest of the process instead
+	static void Stop();
+	static bool IsRunning() { return running; }
+	static void BeginFrame(std::vector<SDL_Event>& events);
+	static void WaitForFrame();
+	static void RunOnRenderThread(const std::function<void()>& task);
+	static void RequestQuit() { quit_requested = true; }
+	static bool QuitRequested() { return quit_requested; }
+};
@@ -24,29 +24,56 @@
 
 #include "SDL_image.h"
 #include "SDL.h"
+#include "InputRecording.h"
+#include "FrameCapture.h"
+#include "RenderTrace.h"
+#include "FramePacer.h"
 
-enum InputStatus { NOT_INITIALIZED, INPUT_FILE_MISSING, INPUT_FILE_PRESENT };
+enum InputStatus { NOT_INITIALIZED, INPUT_FILE_MISSING, INPUT_FILE_PRESENT, INPUT_RECORDING_PRESENT };
 enum RenderLoggerStatus { RL_NOT_INITIALIZED, RL_NOT_ENABLED, RL_ENABLED };
 
 /* The Helper class contains mostly static functions / data, and doesn't need to be instanced. */
 /* Call the public static functions below via Helper::<function>() */
 class Helper {
 public:
-	/* Turn RECORDING_MODE on to record inputs as you play. */
+	/* Turn RECORDING_MODE on to record inputs as you play. Frames are no longer saved by it (see Frame Capture below). */
 	/* The input file may be fed back in to replay your game session (autograder does this). */
 	inline static const bool RECORDING_MODE = true;
 	inline static const char* USER_INPUT_FILENAME = "sdl_user_input.txt";
+	/* Sessions are recorded in a compact binary format. Rename recorded_sdl_user_input.bin to this to replay one. */
+	inline static const char* USER_INPUT_RECORDING_FILENAME = "sdl_user_input.bin";
+	inline static const char* RECORDED_INPUT_FILENAME = "recorded_sdl_user_input.bin";
 
 	/* The Helper.h function works differently (and thus your program works differently) */
 	/* Depending on whether or not an autograder is testing it. */
 	inline static bool _autograder_mode = false;
 
+	/* FEATURE : Fast Replay */
+	/* Create a "FASTREPLAY" environmental variable while replaying sdl_user_input.bin and the engine */
+	/* runs unthrottled (no frame delay, nothing presented to the window) and quits when the recording ends. */
+	inline static bool _fast_replay_mode = false;
+
+	/* FEATURE : Replay Benchmark */
+	/* Run the engine with --replay-bench <results.json> (and --game-dir <dir> to point it at a game) to play that game's */
+	/* sdl_user_input.txt or sdl_user_input.bin back as fast as it will go. The session ends with the recording, and the */
+	/* results file gets the frame time distribution, the slowest frames by phase and a hash of the final frame (see BenchReport.h). */
+	inline static bool _replay_benchmark_mode = false;
+
+	/* Set by the engine when it runs with no window or renderer (--headless). */
+	/* Headless runs are unthrottled, don't record input, and end frames with HeadlessFrameEnd() instead of SDL_RenderPresent(). */
+	inline static bool _headless_mode = false;
+
+	/* Set by the engine when game.config asks for "pipelined_rendering". Scripts run one frame ahead on their own */
+	/* thread, so the frame being presented (render_frame_number) trails the one being simulated (frame_number). */
+	inline static bool _pipelined_mode = false;
+
 	/* One way the autograder gauges success is by comparing your "frames" (renderings) to */
 	/* that of a staff solution program fed the exact same input. These are placed into a "frames" folder. */
 	inline static std::string frame_directory_relative_path = "frames";
 
-	/* The frame_number advances with every call to Helper::SDL_RenderPresent() */
+	/* The frame_number advances with every call to Helper::SDL_RenderPresent(), or AdvancePipelinedFrame() when pipelined */
 	static inline int frame_number = 0;
+	static inline int render_frame_number = 0;
 	static inline Uint32 current_frame_start_timestamp = 0;
 	static int GetFrameNumber() { return frame_number; }
 
@@ -63,7 +90,7 @@ public:
 
 	static SDL_Renderer* SDL_CreateRenderer(SDL_Window* window, int index, Uint32 flags)
 	{
-		if (IsAutograderMode())
+		if (IsAutograderMode() || IsFastReplayMode() || _replay_benchmark_mode)
 			flags &= ~SDL_RENDERER_PRESENTVSYNC; // VSync is disabled to let frames render faster in the autograder.
 
 		SDL_Renderer* renderer = ::SDL_CreateRenderer(window, index, flags);
@@ -82,7 +109,7 @@ public:
 		return ::SDL_PollEvent(e);
 	}
 
-	/* Wrapper that renders to screen while also persisting to a .BMP file */
+	/* Wrapper that renders to screen while also capturing the frame to disk when frame capture is on */
 	static void SDL_RenderPresent(SDL_Renderer* renderer)
 	{
 		if (renderer == nullptr)
@@ -98,79 +125,61 @@ public:
 		}
 
 		static bool initialized = false;
-		static SDL_Surface* saving_surface = nullptr;
 
-		if (RECORDING_MODE || _autograder_mode)
+		if (!initialized)
 		{
-			if (!initialized)
-			{
-				/* Check for existence of frames folder and establish it if necessary. */
-				if (!std::filesystem::exists(frame_directory_relative_path))
-				{
-					std::filesystem::create_directory(frame_directory_relative_path);
-				}
-
-				/* Create reusable surface. */
-				int height, width;
-				SDL_GetRendererOutputSize(renderer, &width, &height);
-				saving_surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 24, SDL_PIXELFORMAT_RGB24);
-
-				current_frame_start_timestamp = SDL_GetTicks();
-				frame_number = 0;
-				initialized = true;
-			}
-
-			/* Read the current renderer's data and persist it as a .bmp file to disk (BMP format is fast-to-write compared to PNG). */
-			if (SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_RGB24, saving_surface->pixels, saving_surface->pitch) != 0) {
-				SDL_Log("SDL_RenderReadPixels() failed: %s", SDL_GetError());
-			}
-			std::stringstream filenameStream;
-			filenameStream << "frame_" << std::setw(5) << std::setfill('0') << frame_number << ".bmp";
-			std::string output_file_name = filenameStream.str();
-			std::string output_file_path = frame_directory_relative_path + "/" + output_file_name;
-
-			if (SDL_SaveBMP(saving_surface, output_file_path.c_str()) != 0) {
-				SDL_Log("SDL_SaveBMP() failed: %s", SDL_GetError());
-			}
+			/* Frames are only captured when asked for; the autograder always gets every frame as a .bmp. */
+			if (_autograder_mode)
+				FrameCapture::Init(renderer, frame_directory_relative_path, FrameCapture::FORMAT_BMP, 1);
+			else if (IsFrameCaptureMode())
+				FrameCapture::Init(renderer, frame_directory_relative_path, GetFrameCaptureFormat(), GetFrameCaptureInterval());
+
+			current_frame_start_timestamp = SDL_GetTicks();
+			initialized = true;
 		}
 
+		/* Readback happens here; encoding and writing the file happen on FrameCapture's worker threads. */
+		if (FrameCapture::IsEnabled())
+			FrameCapture::Capture(renderer, render_frame_number);
+
 		/* Present and then wait for the next frame to begin */
-		if (!_autograder_mode)
+		if (!_autograder_mode && !_fast_replay_mode)
 			::SDL_RenderPresent(renderer); // The autograder doesn't need to render to window.
 		SDL_Delay();
+		if (!_pipelined_mode)
+			render_frame_number = ++frame_number;
+	}
+
+	/* Pipelined stand-in for the frame advance in SDL_RenderPresent: called between frames, while the simulation thread is idle. */
+	/* The frame that just finished simulating is the one the render thread draws next. */
+	static void AdvancePipelinedFrame()
+	{
+		render_frame_number = frame_number;
 		frame_number++;
 	}
 
+	/* Headless stand-in for SDL_RenderPresent: there is nothing to present or capture, so just advance the frame. */
+	static void HeadlessFrameEnd()
+	{
+		FramePacer::EndFrame(true);
+		render_frame_number = ++frame_number;
+	}
+
 	/* FEATURE : Render Logger */
-	/* Create a "RENDERLOGGER" environmental variable, run your engine, and check render_logger.txt. */
-	/* Use to compare to test case render_logger.txt files to see what goes wrong in your render. */
+	/* Create a "RENDERLOGGER" environmental variable, run your engine, and check render_trace.bin. */
+	/* The trace is binary so that logging doesn't slow the run down; convert it into the usual render_logger.txt with */
+	/* tools/render_trace_to_text (make tools) to compare against test case render_logger.txt files. */
 	static inline RenderLoggerStatus render_logger_mode = RL_NOT_INITIALIZED;
-	static inline std::ofstream render_logging_file;
+	inline static const char* RENDER_TRACE_FILENAME = "render_trace.bin";
 	static void CheckForRenderLoggerInit()
 	{
 		/* Check environmental variable on first call. */
 		if (render_logger_mode == RL_NOT_INITIALIZED)
 		{
-			if (IsLoggingMode())
-			{
+			if (IsLoggingMode() && RenderTrace::Init(RENDER_TRACE_FILENAME))
 				render_logger_mode = RL_ENABLED;
-				std::ofstream file("render_logger.txt", std::ios::out); // delete the file if it exists.
-				render_logging_file.open("render_logger.txt", std::ios::app);
-
-				if (!render_logging_file.is_open())
-				{
-					std::cerr << "Error : Failed to open render_logger.txt for writing." << std::endl;
-				}
-
-				render_logging_file << "== RENDER LOGGER ==" << std::endl;
-				render_logging_file << "Study the following SDL_RenderCopyEx() calls to debug render-related issues." << std::endl;
-				render_logging_file << "Enable render logger mode on your computer by setting the RENDERLOGGER environmental variable." << std::endl;
-				render_logging_file << "frame:actor_id:actor_name" << std::endl << std::endl;
-			}
 			else
-			{
 				render_logger_mode = RL_NOT_ENABLED;
-			}
 		}
 	}
 
@@ -207,23 +216,106 @@ public:
 
 		CheckForRenderLoggerInit();
 
-		/* Log render operation to file if necessary */
+		/* Log render operation to the trace if necessary */
 		if (render_logger_mode == RL_ENABLED)
 		{
 			float x_scale = 1;
 			float y_scale = 1;
 			SDL_RenderGetScale(renderer, &x_scale, &y_scale);
 
-			render_logging_file << GetFrameNumber() << ":" << actor_id << ":" << actor_name;
-			if (dstrect != nullptr)
-				render_logging_file << " dstrect " << dstrect->x << " " << dstrect->y << " " << dstrect->w << " " << dstrect->h;
+			RenderTrace::Draw(render_frame_number, actor_id, actor_name, texture,
+				dstrect != nullptr ? &dstrect->x : nullptr, angle, center != nullptr ? &center->x : nullptr,
+				static_cast<int>(flip), x_scale, y_scale);
+		}
+	}
+
+	/* FEATURE : Frame Capture */
+	/* Create a "FRAMECAPTURE" environmental variable to save every presented frame to the frames folder. */
+	/* Set it to a number N to only keep every Nth frame, and set "FRAMECAPTURE_FORMAT" to bmp for .bmp files instead of .qoi. */
+	static bool IsFrameCaptureMode() {
+		return IsEnvVariableSet("FRAMECAPTURE");
+	}
+
+	static int GetFrameCaptureInterval() {
+		try {
+			return std::max(1, std::stoi(GetEnvVariable("FRAMECAPTURE")));
+		}
+		catch (const std::exception&) {
+			return 1;
+		}
+	}
+
+	static FrameCapture::Format GetFrameCaptureFormat() {
+		return GetEnvVariable("FRAMECAPTURE_FORMAT") == "bmp" ? FrameCapture::FORMAT_BMP : FrameCapture::FORMAT_QOI;
+	}
+
+	static bool IsFastReplayMode() {
+		return IsEnvVariableSet("FASTREPLAY");
+	}
+
+	static bool IsAutograderMode() {
+		return IsEnvVariableSet("AUTOGRADER");
+	}
+
+	/* FEATURE : Lua Profiler */
+	/* Create a "LUAPROFILER" environmental variable, run your engine, and check lua_profile.folded. */
+	/* Set it to a number above 1 to change how many Lua instructions pass between samples (default 1000). */
+	static bool IsLuaProfilerMode() {
+		return IsEnvVariableSet("LUAPROFILER");
+	}
+
+	/* FEATURE : Frame Profiler */
+	/* Create a "FRAMEPROFILER" environmental variable to time each phase of the frame (see PROFILE_SCOPE in Profiler.h). */
+	/* Open the resulting frame_profile.json in chrome://tracing or ui.perfetto.dev; per-zone min/avg/p99 are printed on exit. */
+	static bool IsFrameProfilerMode() {
+		return IsEnvVariableSet("FRAMEPROFILER");
+	}
+
+	/* FEATURE : Allocation Tracker */
+	/* Create an "ALLOCTRACKER" environmental variable to count heap allocations per frame and per subsystem (see ALLOC_SCOPE in AllocTracker.h). */
+	/* Set it to "steady" to fail the run (exit code 1) on any allocation once "ALLOCTRACKER_WARMUP" frames (default 60) have passed since a scene load. */
+	static bool IsAllocTrackerMode() {
+		return IsEnvVariableSet("ALLOCTRACKER");
+	}
+
+	static bool IsAllocTrackerSteadyMode() {
+		return GetEnvVariable("ALLOCTRACKER") == "steady";
+	}
 
-			render_logging_file << " angle " << angle;
-			if (center != nullptr)
-				render_logging_file << " center " << center->x << " " << center->y;
+	static int GetAllocTrackerWarmup() {
+		try {
+			return std::max(0, std::stoi(GetEnvVariable("ALLOCTRACKER_WARMUP")));
+		}
+		catch (const std::exception&) {
+			return 60;
+		}
+	}
 
-			render_logging_file << " flip " << flip << " renderscale " << x_scale << " " << y_scale << std::endl;
+	/* FEATURE : State Hash */
+	/* Create a "STATEHASH" environmental variable to write a hash of the simulation state (actors, rigid bodies, particles and */
+	/* component tables) after every frame to state_hash.bin. Run two builds (or a build and a replay) on the same input and */
+	/* compare their logs with tools/state_hash_diff (make tools) to find the first frame where they diverge (see StateHash.h). */
+	static bool IsStateHashMode() {
+		return IsEnvVariableSet("STATEHASH");
+	}
+
+	/* Returns the value of an environmental variable, or an empty string if it is not set. */
+	static std::string GetEnvVariable(const char* env_variable_name)
+	{
+#ifdef _WIN32
+		char* val = nullptr;
+		size_t length = 0;
+		_dupenv_s(&val, &length, env_variable_name);
+		if (val) {
+			std::string result = val;
+			free(val);
+			return result;
 		}
+		return "";
+#else
+		const char* val = std::getenv(env_variable_name);
+		return val ? std::string(val) : std::string();
+#endif
 	}
 
 	/* This encourages students to keep their data in float form as long as possible. We handle truncating to ints at the very end for them, as necessary. */
@@ -267,7 +359,14 @@ public:
 private:
 	static inline std::unordered_map<int, std::queue<SDL_Event>> frame_to_user_input;
 	static inline InputStatus input_status = NOT_INITIALIZED;
-	static inline std::ofstream recording_file;
+	static inline int last_input_frame = -1;
+
+	static bool IsInputReplayFinished()
+	{
+		if (input_status == INPUT_RECORDING_PRESENT)
+			return InputRecording::IsFinished(frame_number);
+		return input_status == INPUT_FILE_PRESENT && frame_number > last_input_frame;
+	}
 
 	/* Do not use SDL_GetKeyboardState(), as it will not observe the input file. */
 	static void SDL_ConsiderInputFile()
@@ -289,79 +388,29 @@ private:
 				}
 			}
 		}
+		else if (input_status == INPUT_RECORDING_PRESENT)
+		{
+			InputRecording::PushFrameEvents(frame_number);
+		}
 
-		/* Recording mode (primarily for course staff usage) */
-		if (RECORDING_MODE && input_status != INPUT_FILE_PRESENT && !_autograder_mode) {
-
-			/* Peek at incoming events so we may record them before the student code consumes them. */
-			SDL_PumpEvents();
-			SDL_Event incoming_events[100];
-			int num_events = SDL_PeepEvents(incoming_events, 100, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
-
-			/* Filter for relevant events */
-			std::vector<SDL_Event> relevant_events;
-			for (int i = 0; i < num_events; i++) {
-
-				Uint32 event_type = incoming_events[i].type;
-				if (event_type == SDL_KEYUP || event_type == SDL_KEYDOWN || event_type == SDL_MOUSEMOTION || event_type == SDL_MOUSEBUTTONDOWN || event_type == SDL_MOUSEBUTTONUP || event_type == SDL_MOUSEWHEEL || event_type == SDL_QUIT)
-					relevant_events.push_back(incoming_events[i]);
-			}
-
-			/* If there are any events we care about, write them to file. */
-			if (relevant_events.size() > 0)
-			{
-				if (!recording_file.is_open())
-				{
-					recording_file.open("recorded_sdl_user_input.txt");
-				}
-
-				/* Every line begins with a frame number */
-				recording_file << frame_number << ";";
-
-				/* Each frame may have multiple events we need to package up. */
-				for (int i = 0; i < relevant_events.size(); i++) {
-
-					/* Every event begins with an event type */
-					Uint32 event_type = relevant_events[i].type;
-					recording_file << event_type << ",";
-
-					/* Each event could be of multiple types, with differing numbers of parameters. */
-					if (event_type == SDL_KEYDOWN || event_type == SDL_KEYUP)
-					{
-						SDL_Scancode keycode = relevant_events[i].key.keysym.scancode;
-						recording_file << keycode;
-					}
-					else if (event_type == SDL_MOUSEMOTION)
-					{
-						Sint32 x = relevant_events[i].motion.x;
-						Sint32 y = relevant_events[i].motion.y;
-						recording_file << x << "," << y;
-					}
-					else if (event_type == SDL_MOUSEBUTTONDOWN)
-					{
-						int button_index = static_cast<int>(relevant_events[i].button.button);
-						recording_file << button_index;
-					}
-					else if (event_type == SDL_MOUSEBUTTONUP)
-					{
-						int button_index = static_cast<int>(relevant_events[i].button.button);
-						recording_file << button_index;
-					}
-					else if (event_type == SDL_MOUSEWHEEL)
-					{
-						float scroll_amount = relevant_events[i].wheel.preciseY;
-						recording_file << scroll_amount;
-					}
-
-					/* Every event ends with a semicolon */
-					recording_file << ";";
-				}
+		/* Fast replay has no one at the keyboard to close the window, so end the session with the recording. */
+		static bool quit_sent = false;
+		if (_fast_replay_mode && !quit_sent && IsInputReplayFinished())
+		{
+			quit_sent = true;
+			SDL_Event quit_event{};
+			quit_event.type = SDL_QUIT;
+			SDL_PushEvent(&quit_event);
+		}
 
-				/* Every line ends with newline, denoting the end of the frame. */
-				recording_file << std::endl;
-			}
+		/* Recording mode (primarily for course staff usage) */
+		/* Events are captured by InputRecording as SDL queues them; each frame only marks where the last one ended. */
+		if (RECORDING_MODE && input_status == INPUT_FILE_MISSING && !_autograder_mode && !_headless_mode)
+		{
+			if (!InputRecording::IsRecording())
+				InputRecording::StartRecording(RECORDED_INPUT_FILENAME);
 
-			// Program will auto-close recording_user_input.txt file when it exits.
+			InputRecording::BeginFrame(frame_number);
 		}
 	}
 
@@ -390,33 +439,14 @@ private:
 		return false;
 	}
 
-	static bool IsAutograderMode() {
-		return IsEnvVariableSet("AUTOGRADER");
-	}
-
 	static bool IsLoggingMode() {
 		return IsEnvVariableSet("RENDERLOGGER");
 	}
 
-	/* The engine will aim for 60fps (16ms per frame) during a normal play session. */
-	/* If the engine detects it is being autograded, it will run as fast as possible. */
+	/* The engine will aim for the target_fps in rendering.config (default 60, 0 for uncapped) during a normal play session. */
+	/* If the engine detects it is being autograded, it will run as fast as possible. See FramePacer.h. */
 	static void SDL_Delay() {
-
-		if (_autograder_mode)
-		{
-			//::SDL_Delay(1); Don't bother delaying at all. Gotta go fast when autograding.
-		}
-		else
-		{
-			Uint32 current_frame_end_timestamp = SDL_GetTicks();  // Record end time of the frame
-			Uint32 current_frame_duration_milliseconds = current_frame_end_timestamp - current_frame_start_timestamp;
-			Uint32 desired_frame_duration_milliseconds = 16;
-
-			int delay_ticks = std::max(static_cast<int>(desired_frame_duration_milliseconds) - static_cast<int>(current_frame_duration_milliseconds), 1);
-
-			::SDL_Delay(delay_ticks);
-		}
-
+		FramePacer::EndFrame(_autograder_mode || _fast_replay_mode);
 		current_frame_start_timestamp = SDL_GetTicks();  // Record start time of the frame
 	}
 
@@ -425,6 +455,14 @@ private:
 		if (IsAutograderMode())
 			_autograder_mode = true;
 
+		if (!std::filesystem::exists(USER_INPUT_FILENAME) && std::filesystem::exists(USER_INPUT_RECORDING_FILENAME)
+			&& InputRecording::OpenReplay(USER_INPUT_RECORDING_FILENAME))
+		{
+			input_status = INPUT_RECORDING_PRESENT;
+			_fast_replay_mode = IsFastReplayMode() || _replay_benchmark_mode;
+			return;
+		}
+
 		if (!std::filesystem::exists(USER_INPUT_FILENAME))
 		{
 			input_status = INPUT_FILE_MISSING;
@@ -440,6 +478,7 @@ private:
 
 			std::getline(iss, frameStr, ';');
 			int frameNumber = std::stoi(frameStr);
+			last_input_frame = std::max(last_input_frame, frameNumber);
 
 			if (frame_to_user_input.find(frameNumber) == frame_to_user_input.end())
 				frame_to_user_input[frameNumber] = std::queue<SDL_Event>();
@@ -515,6 +554,8 @@ private:
 		}
 
 		input_status = INPUT_FILE_PRESENT;
+		/* Text recordings are only replayed at full speed for benchmarking; the autograder has its own way of ending the run. */
+		_fast_replay_mode = _replay_benchmark_mode;
 	}
 };
 
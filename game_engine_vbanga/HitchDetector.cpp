@@ -0,0 +1,103 @@
+#include "HitchDetector.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+const char* const HitchDetector::PHASE_NAMES[PHASE_COUNT] = {
+	"PollEvents", "Input", "start", "InputHooks", "update", "Timers", "lateUpdate", "alterActors",
+	"Input::LateUpdate", "fixedUpdate", "RigidBody::step", "checkForChange", "Render", "Present"
+};
+
+bool HitchDetector::enabled = false;
+Uint64 HitchDetector::budget_ticks = 0;
+double HitchDetector::ticks_to_ms = 0.0;
+Uint64 HitchDetector::last_frame_end = 0;
+Uint64 HitchDetector::phase_ticks[PHASE_COUNT] = {};
+float HitchDetector::last_phase_ms[PHASE_COUNT] = {};
+int HitchDetector::asset_loads = 0;
+HitchDetector::FrameRecord HitchDetector::window[WINDOW];
+size_t HitchDetector::window_next = 0;
+size_t HitchDetector::window_count = 0;
+int HitchDetector::quiet_until_frame = -1;
+size_t HitchDetector::hitch_count = 0;
+
+const char* const HITCH_LOG_FILENAME = "hitches.log";
+
+void HitchDetector::Configure(double budget_ms) {
+	ticks_to_ms = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+	enabled = budget_ms > 0.0;
+	budget_ticks = enabled ? static_cast<Uint64>(budget_ms / ticks_to_ms) : 0;
+}
+
+void HitchDetector::Start() {
+	last_frame_end = SDL_GetPerformanceCounter();
+}
+
+void HitchDetector::EndFrame(int frame, lua_State* L, size_t actor_count) {
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 frame_ticks = now - last_frame_end;
+	last_frame_end = now;
+
+	if (enabled) {
+		FrameRecord& record = window[window_next];
+		record.frame = frame;
+		record.frame_ms = static_cast<float>(frame_ticks * ticks_to_ms);
+		for (int phase = 0; phase < PHASE_COUNT; phase++) {
+			record.phase_ms[phase] = static_cast<float>(phase_ticks[phase] * ticks_to_ms);
+		}
+		record.lua_kb = L ? lua_gc(L, LUA_GCCOUNT, 0) : 0;
+		record.asset_loads = asset_loads;
+		record.actors = static_cast<int>(actor_count);
+		window_next = (window_next + 1) % WINDOW;
+		if (window_count < WINDOW) window_count++;
+
+		if (frame_ticks > budget_ticks) {
+			WriteHitch(record);
+		}
+	}
+
+	for (int phase = 0; phase < PHASE_COUNT; phase++) {
+		last_phase_ms[phase] = static_cast<float>(phase_ticks[phase] * ticks_to_ms);
+		phase_ticks[phase] = 0;
+	}
+	asset_loads = 0;
+}
+
+void HitchDetector::WriteHitch(const FrameRecord& hitch) {
+	hitch_count++;
+	FILE* log = std::fopen(HITCH_LOG_FILENAME, "a");
+	if (!log) {
+		std::cerr << "Error : Failed to open " << HITCH_LOG_FILENAME << " for writing." << std::endl;
+		enabled = false;
+		return;
+	}
+
+	if (hitch.frame <= quiet_until_frame) {
+		std::fprintf(log, "hitch: frame %d took %.2f ms (budget %.2f ms), see the window above\n",
+			hitch.frame, hitch.frame_ms, budget_ticks * ticks_to_ms);
+		std::fclose(log);
+		return;
+	}
+	quiet_until_frame = hitch.frame + static_cast<int>(WINDOW);
+
+	std::fprintf(log, "\nhitch: frame %d took %.2f ms (budget %.2f ms), last %zu frames:\n",
+		hitch.frame, hitch.frame_ms, budget_ticks * ticks_to_ms, window_count);
+	std::fprintf(log, "%8s %9s", "frame", "total");
+	for (const char* name : PHASE_NAMES) {
+		std::fprintf(log, " %*s", std::max(8, static_cast<int>(std::strlen(name))), name);
+	}
+	std::fprintf(log, " %9s %7s %7s\n", "lua_kb", "loads", "actors");
+
+	//Oldest first, so the hitch is the last row
+	size_t oldest = (window_next + WINDOW - window_count) % WINDOW;
+	for (size_t i = 0; i < window_count; i++) {
+		const FrameRecord& record = window[(oldest + i) % WINDOW];
+		std::fprintf(log, "%8d %9.2f", record.frame, record.frame_ms);
+		for (int phase = 0; phase < PHASE_COUNT; phase++) {
+			std::fprintf(log, " %*.2f", std::max(8, static_cast<int>(std::strlen(PHASE_NAMES[phase]))), record.phase_ms[phase]);
+		}
+		std::fprintf(log, " %9d %7d %7d\n", record.lua_kb, record.asset_loads, record.actors);
+	}
+	std::fclose(log);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "SDL.h"
+#include "lua/lua.hpp"
+#include "Profiler.h"
+
+//Always-on hitch detection. The main loop's phases are timed with PROFILE_PHASE, which costs two
+//counter reads, and at the end of each frame the phase times, Lua heap size, asset loads and
+//actor count go into a ring of the last WINDOW frames. When a frame takes longer than the
+//budget, the whole ring is appended to hitches.log so the frames leading up to it can be read
+//back. Further hitches within the next WINDOW frames get a one-line entry instead of another dump.
+//The budget comes from "hitch_budget_ms" in game.config (0 disables it); by default it is two frames
+//at the target frame rate.
+class HitchDetector
+{
+public:
+	enum Phase {
+		PHASE_EVENTS,
+		PHASE_INPUT,
+		PHASE_START,
+		PHASE_INPUT_HOOKS,
+		PHASE_UPDATE,
+		PHASE_TIMERS,
+		PHASE_LATE_UPDATE,
+		PHASE_ALTER_ACTORS,
+		PHASE_LATE_INPUT,
+		PHASE_FIXED_UPDATE,
+		PHASE_PHYSICS,
+		PHASE_SCENE_CHANGE,
+		PHASE_RENDER,
+		PHASE_PRESENT,
+		PHASE_COUNT
+	};
+	static const char* const PHASE_NAMES[PHASE_COUNT];
+	static constexpr size_t WINDOW = 120;
+
+	//Adds its time to the phase and, when FRAMEPROFILER is set, records a profiler zone of the same name
+	class PhaseScope {
+		Profiler::Scope zone;
+		Phase phase;
+		Uint64 begin;
+	public:
+		explicit PhaseScope(Phase which) : zone(PHASE_NAMES[which]), phase(which), begin(SDL_GetPerformanceCounter()) {}
+		~PhaseScope() { phase_ticks[phase] += SDL_GetPerformanceCounter() - begin; }
+		PhaseScope(const PhaseScope&) = delete;
+		PhaseScope& operator=(const PhaseScope&) = delete;
+	};
+private:
+	struct FrameRecord {
+		int frame = 0;
+		float frame_ms = 0.0f;
+		float phase_ms[PHASE_COUNT] = {};
+		int lua_kb = 0;
+		int asset_loads = 0;
+		int actors = 0;
+	};
+
+	static bool enabled;
+	static Uint64 budget_ticks;
+	static double ticks_to_ms;
+	static Uint64 last_frame_end;
+	static Uint64 phase_ticks[PHASE_COUNT];
+	static float last_phase_ms[PHASE_COUNT];
+	static int asset_loads;
+	static FrameRecord window[WINDOW];
+	static size_t window_next;
+	static size_t window_count;
+	static int quiet_until_frame;
+	static size_t hitch_count;
+
+	static void WriteHitch(const FrameRecord& hitch);
+public:
+	static void Configure(double budget_ms);
+	static void Start();
+	static void CountAssetLoad() { asset_loads++; }
+	static void EndFrame(int frame, lua_State* L, size_t actor_count);
+	static size_t GetHitchCount() { return hitch_count; }
+	//Phase times of the frame EndFrame last closed, whether or not hitch detection is on
+	static const float* GetLastPhaseMs() { return last_phase_ms; }
+};
+
+#define PROFILE_PHASE(phase) HitchDetector::PhaseScope PROFILE_CONCAT(phase_scope_, __LINE__)(phase)
@@ -1,34 +1,56 @@
 #include "ImageDB.h"
 #include "Helper.h"
 #include "TextDB.h"
+#include "FramePipeline.h"
+#include "Profiler.h"
+#include "HitchDetector.h"
+#include "AllocTracker.h"
 
 
 std::unordered_map <std::string, SDL_Texture*> ImageDB::images;
 SDL_Renderer* ImageDB::renderer;
 
-std::vector<ImageDB::UIType> ImageDB::ui_images;
-std::vector<ImageDB::ImageType> ImageDB::scene_images;
-std::vector<ImageDB::ImagePixels> ImageDB::pixel_images;
+ImageDB::DrawList ImageDB::draw_lists[3];
+int ImageDB::write_list = 0;
+int ImageDB::ready_list = 1;
+int ImageDB::render_list = 2;
 
 int ImageDB::frameWidth;
 int ImageDB::frameHeight;
 
 glm::vec2 ImageDB::camera;
 float ImageDB::zoomFactor = 1.0f;
+bool ImageDB::headless = false;
+size_t ImageDB::draw_count = 0;
+std::atomic<int> ImageDB::last_draw_calls(0);
+std::atomic<int> ImageDB::last_texture_switches(0);
+size_t ImageDB::texture_bytes = 0;
 
 
-void ImageDB::LoadImage(const std::string& imgName) {
-    if (images.count(imgName) != 0) {
+SDL_Texture* ImageDB::LoadImage(const std::string& imgName) {
+    auto it = images.find(imgName);
+    if (it != images.end()) {
         //Now I can call it without checking each actor - done internally
-        return;
+        return it->second;
     }
 
     if (!std::filesystem::exists("resources/images/" + imgName + ".png")) {
         std::cout << "error: missing image " << imgName;
         exit(0);
     }
+    if (headless) {
+        images.insert({ imgName, nullptr });
+        return nullptr;
+    }
+    PROFILE_SCOPE("ImageDB::LoadImage");
+    ALLOC_SCOPE(TAG_IMAGES);
+    HitchDetector::CountAssetLoad();
     //Make sure that there isn't already a value for that imgName
-    images.insert({imgName, IMG_LoadTexture(renderer, ("resources/images/" + imgName + ".png").c_str()) });
+    SDL_Texture* texture = nullptr;
+    FramePipeline::RunOnRenderThread([&]() { texture = IMG_LoadTexture(renderer, ("resources/images/" + imgName + ".png").c_str()); });
+    texture_bytes += TextureBytes(texture);
+    images.insert({imgName, texture });
+    return texture;
 }
 
 SDL_Texture* ImageDB::GetImage(const std::string& imgName) {
@@ -39,18 +61,36 @@ SDL_Texture* ImageDB::GetImage(const std::string& imgName) {
 }
 
 void ImageDB::DrawUI(const std::string& image_name, float x, float y) {
-    LoadImage(image_name);
+    DrawUITexture(LoadImage(image_name), x, y);
+}
+
+void ImageDB::DrawUIEx(const std::string& image_name, float x, float y, float r, float g, float b, float a, float sorting_order) {
+    DrawUITextureEx(LoadImage(image_name), x, y, r, g, b, a, sorting_order);
+}
+
+void ImageDB::Draw(const std::string& image_name, float x, float y) {
+    DrawTexture(LoadImage(image_name), x, y);
+}
+
+void ImageDB::DrawEx(const std::string& image_name, float x, float y, float rotation_degrees, float scale_x, float scale_y, float pivot_x, float pivot_y, float r, float g, float b, float a, float sorting_order) {
+    DrawTextureEx(LoadImage(image_name), x, y, rotation_degrees, scale_x, scale_y, pivot_x, pivot_y, r, g, b, a, sorting_order);
+}
+
+void ImageDB::DrawUITexture(SDL_Texture* texture, float x, float y) {
+    if (headless) { draw_count++; return; }
+    ALLOC_SCOPE(TAG_IMAGES);
     UIType draw;
-    draw.image_name = image_name;
+    draw.texture = texture;
     draw.x = x;
     draw.y = y;
-    ui_images.push_back(draw);
+    draw_lists[write_list].ui_images.push_back(draw);
 }
 
-void ImageDB::DrawUIEx(const std::string& image_name, float x, float y, float r, float g, float b, float a, float sorting_order) {
-    LoadImage(image_name);
+void ImageDB::DrawUITextureEx(SDL_Texture* texture, float x, float y, float r, float g, float b, float a, float sorting_order) {
+    if (headless) { draw_count++; return; }
+    ALLOC_SCOPE(TAG_IMAGES);
     UIType draw;
-    draw.image_name = image_name;
+    draw.texture = texture;
     draw.x = x;
     draw.y = y;
     draw.r = r;
@@ -58,13 +98,14 @@ void ImageDB::DrawUIEx(const std::string& image_name, float x, float y, float r,
     draw.b = b;
     draw.a = a;
     draw.sorting_order = sorting_order;
-    ui_images.push_back(draw);
+    draw_lists[write_list].ui_images.push_back(draw);
 }
 
-void ImageDB::Draw(const std::string& image_name, float x, float y) {
-    LoadImage(image_name);
+void ImageDB::DrawTexture(SDL_Texture* texture, float x, float y) {
+    if (headless) { draw_count++; return; }
+    ALLOC_SCOPE(TAG_IMAGES);
     ImageType draw;
-    draw.image_name = image_name;
+    draw.texture = texture;
     draw.x = x;
     draw.y = y;
     draw.scale_x = 1.0f;
@@ -72,13 +113,14 @@ void ImageDB::Draw(const std::string& image_name, float x, float y) {
     draw.rotation_degrees = 0.0f;
     draw.pivot_x = 0.5f;
     draw.pivot_y = 0.5f;
-    scene_images.push_back(draw);
+    draw_lists[write_list].scene_images.push_back(draw);
 }
 
-void ImageDB::DrawEx(const std::string& image_name, float x, float y, float rotation_degrees, float scale_x, float scale_y, float pivot_x, float pivot_y, float r, float g, float b, float a, float sorting_order) {
-    LoadImage(image_name);
+void ImageDB::DrawTextureEx(SDL_Texture* texture, float x, float y, float rotation_degrees, float scale_x, float scale_y, float pivot_x, float pivot_y, float r, float g, float b, float a, float sorting_order) {
+    if (headless) { draw_count++; return; }
+    ALLOC_SCOPE(TAG_IMAGES);
     ImageType draw;
-    draw.image_name = image_name;
+    draw.texture = texture;
     draw.x = x;
     draw.y = y;
     draw.rotation_degrees = rotation_degrees;
@@ -91,10 +133,12 @@ void ImageDB::DrawEx(const std::string& image_name, float x, float y, float rota
     draw.b = b;
     draw.a = a;
     draw.sorting_order = sorting_order;
-    scene_images.push_back(draw);
+    draw_lists[write_list].scene_images.push_back(draw);
 }
 
 void ImageDB::DrawPixel(float x, float y, float r, float g, float b, float a) {
+    if (headless) { draw_count++; return; }
+    ALLOC_SCOPE(TAG_IMAGES);
     ImagePixels pixel;
     pixel.x = x;
     pixel.y = y;
@@ -102,17 +146,41 @@ void ImageDB::DrawPixel(float x, float y, float r, float g, float b, float a) {
     pixel.g = g;
     pixel.b = b;
     pixel.a = a;
-    pixel_images.push_back(pixel);
+    draw_lists[write_list].pixel_images.push_back(pixel);
+}
+
+void ImageDB::SubmitFrame() {
+    DrawList& submitted = draw_lists[write_list];
+    submitted.camera = camera;
+    submitted.zoomFactor = zoomFactor;
+    std::swap(write_list, ready_list);
+    TextDB::SubmitFrame();
+}
+
+void ImageDB::AcquireFrame() {
+    std::swap(ready_list, render_list);
+    TextDB::AcquireFrame();
 }
 
 void ImageDB::RenderAll() {
+    if (headless) return;
+    PROFILE_SCOPE("ImageDB::RenderAll");
+    DrawList& frame = draw_lists[render_list];
+    std::vector<ImageType>& scene_images = frame.scene_images;
+    std::vector<UIType>& ui_images = frame.ui_images;
+    std::vector<ImagePixels>& pixel_images = frame.pixel_images;
+    const glm::vec2& camera = frame.camera;
+    const float zoomFactor = frame.zoomFactor;
+    int draw_calls = 0;
+    int texture_switches = 0;
+    SDL_Texture* last_texture = nullptr;
     std::stable_sort(scene_images.begin(), scene_images.end(), [](const ImageType& a, const ImageType& b) {
         return a.sorting_order < b.sorting_order;
         });
     float UNIT_TO_PIXEL = 100;
     SDL_RenderSetScale(renderer, zoomFactor, zoomFactor);
     for (ImageType& img : scene_images) {
-        SDL_Texture* texture = GetImage(img.image_name);
+        SDL_Texture* texture = img.texture;
         if (!texture) continue;
 
         glm::vec2 targetPos = glm::vec2(img.x, img.y) - camera;
@@ -141,6 +209,11 @@ void ImageDB::RenderAll() {
         SDL_SetTextureAlphaMod(texture, img.a);
 
         Helper::SDL_RenderCopyEx(-1, "scene", renderer, texture, nullptr, &dst, img.rotation_degrees, &pivot, SDL_FLIP_NONE);
+        draw_calls++;
+        if (texture != last_texture) {
+            texture_switches++;
+            last_texture = texture;
+        }
         SDL_RenderSetScale(renderer, zoomFactor, zoomFactor);
 
         SDL_SetTextureColorMod(texture, 255, 255, 255);
@@ -152,7 +225,7 @@ void ImageDB::RenderAll() {
         return a.sorting_order < b.sorting_order;
         });
     for (UIType& ui : ui_images) {
-        SDL_Texture* texture = GetImage(ui.image_name);
+        SDL_Texture* texture = ui.texture;
         if (!texture) continue;
 
         float tex_w, tex_h;
@@ -168,6 +241,11 @@ void ImageDB::RenderAll() {
         SDL_SetTextureAlphaMod(texture, ui.a);
 
         Helper::SDL_RenderCopy(renderer, texture, nullptr, &dst);
+        draw_calls++;
+        if (texture != last_texture) {
+            texture_switches++;
+            last_texture = texture;
+        }
 
         SDL_SetTextureColorMod(texture, 255, 255, 255);
         SDL_SetTextureAlphaMod(texture, 255);
@@ -184,6 +262,9 @@ void ImageDB::RenderAll() {
             px.a);
         SDL_RenderDrawPoint(renderer, px.x, px.y);
     }
+    draw_calls += static_cast<int>(pixel_images.size());
+    last_draw_calls = draw_calls;
+    last_texture_switches = texture_switches;
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
 
     scene_images.clear();
@@ -196,13 +277,26 @@ void ImageDB::CreateDefaultParticleTextureWithName(const std::string& name)
     if (images.find(name) != images.end()) {
         return;
     }
+    if (headless) {
+        images[name] = nullptr;
+        return;
+    }
 
     SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 8, 8, 32, SDL_PIXELFORMAT_RGBA8888);
 
     Uint32 white_color = SDL_MapRGBA(surface->format, 255, 255, 255, 255);
     SDL_FillRect(surface, NULL, white_color);
 
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_Texture* texture = nullptr;
+    FramePipeline::RunOnRenderThread([&]() { texture = SDL_CreateTextureFromSurface(renderer, surface); });
     SDL_FreeSurface(surface);
+    texture_bytes += TextureBytes(texture);
     images[name] = texture;
 }
+
+size_t ImageDB::TextureBytes(SDL_Texture* texture)
+{
+    float w = 0.0f, h = 0.0f;
+    Helper::SDL_QueryTexture(texture, &w, &h);
+    return static_cast<size_t>(w) * static_cast<size_t>(h) * 4;
+}
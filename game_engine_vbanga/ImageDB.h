@@ -6,13 +6,14 @@
 #include "SDL.h"
 #include "SDL_image.h"
 #include <queue>
+#include <atomic>
 #include "glm/glm.hpp"
 
 class ImageDB
 {
 private:
 	 struct UIType {
-		std::string image_name;
+		SDL_Texture* texture;
 		float x;
 		float y;
 		float r = 255.0f;
@@ -23,7 +24,7 @@ private:
 	};
 
 	 struct ImageType {
-		std::string image_name;
+		SDL_Texture* texture;
 		float x;
 		float y;
 		float rotation_degrees = 0.0f;
@@ -47,15 +48,35 @@ private:
 		float a;
 	};
 
+	//Everything drawn in one frame, along with the camera it was drawn with. Scripts fill the write
+	//list; SubmitFrame() hands it over as the ready list and AcquireFrame() makes that the render list,
+	//so with pipelined rendering the next frame can be queued while this one is being drawn.
+	 struct DrawList {
+		std::vector<ImageType> scene_images;
+		std::vector<UIType> ui_images;
+		std::vector<ImagePixels> pixel_images;
+		glm::vec2 camera = { 0.0f, 0.0f };
+		float zoomFactor = 1.0f;
+	};
+
 	static std::unordered_map <std::string, SDL_Texture*> images;
 	static SDL_Renderer* renderer;
-	static std::vector<UIType> ui_images;
-	static std::vector<ImageType> scene_images;
-	static std::vector<ImagePixels> pixel_images;
+	static DrawList draw_lists[3];
+	static int write_list;
+	static int ready_list;
+	static int render_list;
 	static int frameWidth;
 	static int frameHeight;
 	static glm::vec2 camera;
 	static float zoomFactor;
+	static bool headless;
+	static size_t draw_count;
+	//What the last RenderAll did, read from the simulation thread when pipelined
+	static std::atomic<int> last_draw_calls;
+	static std::atomic<int> last_texture_switches;
+	static size_t texture_bytes;
+
+	static size_t TextureBytes(SDL_Texture* texture);
 
 public:
 	static void setRenderer(SDL_Renderer* render) { renderer = render; }
@@ -66,13 +87,27 @@ public:
 	static float getPositionY() { return camera.y; }
 	static float getZoom() { return zoomFactor; }
 	static void setZoom(float val) { zoomFactor = val; }
-	static void LoadImage(const std::string&);
+	//With no renderer, images are only checked for existence and draws are counted instead of queued
+	static void setHeadless(bool val) { headless = val; }
+	static size_t getDrawCount() { return draw_count; }
+	static int getLastDrawCalls() { return last_draw_calls; }
+	static int getLastTextureSwitches() { return last_texture_switches; }
+	//Roughly what the loaded images take up in texture memory, at 4 bytes per pixel
+	static size_t getTextureBytes() { return texture_bytes; }
+	static SDL_Texture* LoadImage(const std::string&);
 	static SDL_Texture* GetImage(const std::string&);
 	static void DrawUI(const std::string& image_name, float x, float y);
 	static void DrawUIEx(const std::string& image_name, float x, float y, float r, float g, float b, float a, float sorting_order);
 	static void Draw(const std::string& image_name, float x, float y);
 	static void DrawEx(const std::string& image_name, float x, float y, float rotation_degrees, float scale_x, float scale_y, float pivot_x, float pivot_y, float r, float g, float b, float a, float sorting_order);
 	static void DrawPixel(float x, float y, float r, float g, float b, float a);
+	//Same as above once the image is loaded, for callers that keep hold of the texture
+	static void DrawTexture(SDL_Texture* texture, float x, float y);
+	static void DrawTextureEx(SDL_Texture* texture, float x, float y, float rotation_degrees, float scale_x, float scale_y, float pivot_x, float pivot_y, float r, float g, float b, float a, float sorting_order);
+	static void DrawUITexture(SDL_Texture* texture, float x, float y);
+	static void DrawUITextureEx(SDL_Texture* texture, float x, float y, float r, float g, float b, float a, float sorting_order);
+	static void SubmitFrame();
+	static void AcquireFrame();
 	static void RenderAll();
 	static void CreateDefaultParticleTextureWithName(const std::string& name);
 
@@ -1,26 +1,31 @@
 #include "Input.h"
 #include "Helper.h"
+#include "InputHooks.h"
+#include "FramePipeline.h"
+#include <cctype>
 
 
-std::unordered_map<SDL_Scancode, INPUT_STATE> Input::keyboard_states;
-std::vector<SDL_Scancode> Input::just_became_down_scancodes;
-std::vector<SDL_Scancode> Input::just_became_up_scancodes;
+std::bitset<SDL_NUM_SCANCODES> Input::keys_held;
+std::bitset<SDL_NUM_SCANCODES> Input::keys_just_down;
+std::bitset<SDL_NUM_SCANCODES> Input::keys_just_up;
 
-std::unordered_map<Uint8, INPUT_STATE> Input::mouse_button_states;
-std::vector<Uint8> Input::just_became_down_buttons;
-std::vector<Uint8> Input::just_became_up_buttons;
+std::bitset<Input::BUTTON_COUNT> Input::mouse_held;
+std::bitset<Input::BUTTON_COUNT> Input::mouse_just_down;
+std::bitset<Input::BUTTON_COUNT> Input::mouse_just_up;
 
 glm::vec2 Input::mouse_position;
 float Input::mouse_scroll_this_frame = 0;
 
 SDL_GameController* Input::controller = nullptr;
-std::unordered_map<Uint8, INPUT_STATE> Input::controller_states;
-std::vector<Uint8> Input::just_became_down_controller;
-std::vector<Uint8> Input::just_became_up_controller;
+std::bitset<Input::BUTTON_COUNT> Input::controller_held;
+std::bitset<Input::BUTTON_COUNT> Input::controller_just_down;
+std::bitset<Input::BUTTON_COUNT> Input::controller_just_up;
 glm::vec2 Input::controller_left_stick = {0.0f,0.0f};
 glm::vec2 Input::controller_right_stick = {0.0f,0.0f};
 float Input::controller_trigger_left = 0.0f;
 float Input::controller_trigger_right = 0.0f;
+float Input::controller_axes[SDL_CONTROLLER_AXIS_MAX] = {};
+float Input::stick_dead_zone = 0.0f;
 
 const std::unordered_map<std::string, SDL_Scancode> __keycode_to_scancode = {
 	// Directional (arrow) Keys
@@ -48,6 +53,20 @@ const std::unordered_map<std::string, SDL_Scancode> __keycode_to_scancode = {
 	{"delete", SDL_SCANCODE_DELETE},
 	{"insert", SDL_SCANCODE_INSERT},
 
+	// Function Keys
+	{"f1", SDL_SCANCODE_F1},
+	{"f2", SDL_SCANCODE_F2},
+	{"f3", SDL_SCANCODE_F3},
+	{"f4", SDL_SCANCODE_F4},
+	{"f5", SDL_SCANCODE_F5},
+	{"f6", SDL_SCANCODE_F6},
+	{"f7", SDL_SCANCODE_F7},
+	{"f8", SDL_SCANCODE_F8},
+	{"f9", SDL_SCANCODE_F9},
+	{"f10", SDL_SCANCODE_F10},
+	{"f11", SDL_SCANCODE_F11},
+	{"f12", SDL_SCANCODE_F12},
+
 	// Character Keys
 	{"space", SDL_SCANCODE_SPACE},
 	{"a", SDL_SCANCODE_A},
@@ -100,12 +119,15 @@ const std::unordered_map<std::string, SDL_Scancode> __keycode_to_scancode = {
 
 void Input::Init() {
 	SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER);
-	keyboard_states.clear();
-	just_became_down_scancodes.clear();
-	just_became_up_scancodes.clear();
-    mouse_button_states.clear();
-    just_became_down_buttons.clear();
-    just_became_up_buttons.clear();
+	keys_held.reset();
+	keys_just_down.reset();
+	keys_just_up.reset();
+    mouse_held.reset();
+    mouse_just_down.reset();
+    mouse_just_up.reset();
+    controller_held.reset();
+    controller_just_down.reset();
+    controller_just_up.reset();
 	
 	for (int i = 0; i < SDL_NumJoysticks(); i++) {
 		if (SDL_IsGameController(i)) {
@@ -118,25 +140,42 @@ void Input::Init() {
 }
 
 void Input::ProcessEvent(const SDL_Event& e) {
+    //A press and a release in the same frame leave only the release visible, same as the old state machine
     if (e.type == SDL_KEYDOWN) {
         SDL_Scancode code = e.key.keysym.scancode;
-        keyboard_states[code] = INPUT_STATE_JUST_BECAME_DOWN;
-        just_became_down_scancodes.push_back(code);
+        keys_held[code] = true;
+        keys_just_down[code] = true;
+        keys_just_up[code] = false;
+        if (!e.key.repeat && InputHooks::HasListeners(InputHooks::HOOK_KEY_DOWN)) {
+            InputHooks::Queue(InputHooks::HOOK_KEY_DOWN, code, true);
+        }
     }
     else if (e.type == SDL_KEYUP) {
         SDL_Scancode code = e.key.keysym.scancode;
-        keyboard_states[code] = INPUT_STATE_JUST_BECAME_UP;
-        just_became_up_scancodes.push_back(code);
+        keys_held[code] = false;
+        keys_just_down[code] = false;
+        keys_just_up[code] = true;
+        if (InputHooks::HasListeners(InputHooks::HOOK_KEY_UP)) {
+            InputHooks::Queue(InputHooks::HOOK_KEY_UP, code, false);
+        }
     }
     else if (e.type == SDL_MOUSEBUTTONDOWN) {
         Uint8 button = e.button.button;
-        mouse_button_states[button] = INPUT_STATE_JUST_BECAME_DOWN;
-        just_became_down_buttons.push_back(button);
+        mouse_held[button] = true;
+        mouse_just_down[button] = true;
+        mouse_just_up[button] = false;
+        if (InputHooks::HasListeners(InputHooks::HOOK_MOUSE_DOWN)) {
+            InputHooks::Queue(InputHooks::HOOK_MOUSE_DOWN, button, true);
+        }
     }
     else if (e.type == SDL_MOUSEBUTTONUP) {
         Uint8 button = e.button.button;
-        mouse_button_states[button] = INPUT_STATE_JUST_BECAME_UP;
-        just_became_up_buttons.push_back(button);
+        mouse_held[button] = false;
+        mouse_just_down[button] = false;
+        mouse_just_up[button] = true;
+        if (InputHooks::HasListeners(InputHooks::HOOK_MOUSE_UP)) {
+            InputHooks::Queue(InputHooks::HOOK_MOUSE_UP, button, false);
+        }
     }
     else if (e.type == SDL_MOUSEWHEEL) {
         mouse_scroll_this_frame += e.wheel.preciseY;
@@ -147,17 +186,29 @@ void Input::ProcessEvent(const SDL_Event& e) {
 	else if (e.type == SDL_CONTROLLERBUTTONDOWN) {
 		Uint8 button = e.cbutton.button;
 		std::cout << "Button " << static_cast<int>(button) << " pressed " << std::endl;
-		controller_states[button] = INPUT_STATE_JUST_BECAME_DOWN;
-		just_became_down_controller.push_back(button);
+		controller_held[button] = true;
+		controller_just_down[button] = true;
+		controller_just_up[button] = false;
+		if (InputHooks::HasListeners(InputHooks::HOOK_CONTROLLER_BUTTON)) {
+			InputHooks::Queue(InputHooks::HOOK_CONTROLLER_BUTTON, button, true);
+		}
 	}
 	else if (e.type == SDL_CONTROLLERBUTTONUP) {
 		Uint8 button = e.cbutton.button;
-		controller_states[button] = INPUT_STATE_JUST_BECAME_UP;
-		just_became_up_controller.push_back(button);
+		controller_held[button] = false;
+		controller_just_down[button] = false;
+		controller_just_up[button] = true;
+		if (InputHooks::HasListeners(InputHooks::HOOK_CONTROLLER_BUTTON)) {
+			InputHooks::Queue(InputHooks::HOOK_CONTROLLER_BUTTON, button, false);
+		}
 	}
 	else if (e.type == SDL_CONTROLLERAXISMOTION) {
+		if (e.caxis.axis < SDL_CONTROLLER_AXIS_MAX) {
+			controller_axes[e.caxis.axis] = std::clamp(e.caxis.value / 32767.0f, -1.0f, 1.0f);
+		}
+
 		auto NormalizeAxis = [](Sint16 value) -> float {
-			const float dead_zone = 0000.0f; // optional: to ignore small accidental input
+			const float dead_zone = stick_dead_zone * 32767.0f; // optional: to ignore small accidental input
 			if (std::abs(value) == 1.0f) return value;
 			if (std::abs(value) < dead_zone) return 0.0f;
 
@@ -192,73 +243,76 @@ void Input::ProcessEvent(const SDL_Event& e) {
 }
 
 void Input::LateUpdate() {
-    for (SDL_Scancode code : just_became_down_scancodes) {
-        keyboard_states[code] = INPUT_STATE_DOWN;
-    }
-    just_became_down_scancodes.clear();
-
-    for (SDL_Scancode code : just_became_up_scancodes) {
-        keyboard_states[code] = INPUT_STATE_UP;
-    }
-    just_became_up_scancodes.clear();
-    for (Uint8 button : just_became_down_buttons) {
-        mouse_button_states[button] = INPUT_STATE_DOWN;
-    }
-    just_became_down_buttons.clear();
-
-    for (Uint8 button : just_became_up_buttons) {
-        mouse_button_states[button] = INPUT_STATE_UP;
-    }
-    just_became_up_buttons.clear();
-
-	for (Uint8 button : just_became_up_controller) {
-		controller_states[button] = INPUT_STATE_UP;
-	}
-	just_became_up_controller.clear();
-
-	for (Uint8 button : just_became_down_controller) {
-		controller_states[button] = INPUT_STATE_DOWN;
-	}
-	just_became_down_controller.clear();
+    keys_just_down.reset();
+    keys_just_up.reset();
+    mouse_just_down.reset();
+    mouse_just_up.reset();
+    controller_just_down.reset();
+    controller_just_up.reset();
 
     mouse_scroll_this_frame = 0.0f;
 }
 
 bool Input::GetKey(std::string keycode) {
-	if (__keycode_to_scancode.count(keycode) == 0) return false;
-    auto it = keyboard_states.find((__keycode_to_scancode.find(keycode)->second));
-    if (it != keyboard_states.end()) {
-        return (it->second == INPUT_STATE_DOWN || it->second == INPUT_STATE_JUST_BECAME_DOWN);
-    }
-    return false;
+	return GetScancodeState(GetScancode(keycode));
 }
 
 bool Input::GetKeyDown(std::string keycode) {
-	if (__keycode_to_scancode.count(keycode) == 0) return false;
-	auto it = keyboard_states.find((__keycode_to_scancode.find(keycode)->second));
-    return (it != keyboard_states.end() && it->second == INPUT_STATE_JUST_BECAME_DOWN);
+	return GetScancodeDown(GetScancode(keycode));
 }
 
 bool Input::GetKeyUp(std::string keycode) {
-	if (__keycode_to_scancode.count(keycode) == 0) return false;
-	auto it = keyboard_states.find((__keycode_to_scancode.find(keycode)->second));
-    return (it != keyboard_states.end() && it->second == INPUT_STATE_JUST_BECAME_UP);
+	return GetScancodeUp(GetScancode(keycode));
+}
+
+SDL_Scancode Input::GetScancode(const std::string& keycode) {
+	auto it = __keycode_to_scancode.find(keycode);
+	return it != __keycode_to_scancode.end() ? it->second : SDL_SCANCODE_UNKNOWN;
+}
+
+bool Input::GetScancodeState(SDL_Scancode scancode) {
+	if (scancode <= SDL_SCANCODE_UNKNOWN || scancode >= SDL_NUM_SCANCODES) return false;
+	return keys_held[scancode];
+}
+
+bool Input::GetScancodeDown(SDL_Scancode scancode) {
+	if (scancode <= SDL_SCANCODE_UNKNOWN || scancode >= SDL_NUM_SCANCODES) return false;
+	return keys_just_down[scancode];
+}
+
+bool Input::GetScancodeUp(SDL_Scancode scancode) {
+	if (scancode <= SDL_SCANCODE_UNKNOWN || scancode >= SDL_NUM_SCANCODES) return false;
+	return keys_just_up[scancode];
+}
+
+void Input::RegisterKeyTable(lua_State* L) {
+	lua_getglobal(L, "Input");
+	lua_createtable(L, 0, static_cast<int>(__keycode_to_scancode.size() * 2));
+	for (const auto& [name, scancode] : __keycode_to_scancode) {
+		lua_pushinteger(L, scancode);
+		lua_setfield(L, -2, name.c_str());
+		//Input.Key.space and Input.Key.Space both work
+		if (std::islower(static_cast<unsigned char>(name[0]))) {
+			std::string capitalized = name;
+			capitalized[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(name[0])));
+			lua_pushinteger(L, scancode);
+			lua_setfield(L, -2, capitalized.c_str());
+		}
+	}
+	lua_setfield(L, -2, "Key");
+	lua_pop(L, 1);
 }
 
 bool Input::GetMouseButton(int button) {
-    auto it = mouse_button_states.find(button);
-    return (it != mouse_button_states.end() &&
-        (it->second == INPUT_STATE_DOWN || it->second == INPUT_STATE_JUST_BECAME_DOWN));
+    return button >= 0 && button < BUTTON_COUNT && mouse_held[button];
 }
 
 bool Input::GetMouseDown(int button) {
-    auto it = mouse_button_states.find(button);
-    return (it != mouse_button_states.end() && it->second == INPUT_STATE_JUST_BECAME_DOWN);
+    return button >= 0 && button < BUTTON_COUNT && mouse_just_down[button];
 }
 
 bool Input::GetMouseUp(int button) {
-    auto it = mouse_button_states.find(button);
-    return (it != mouse_button_states.end() && it->second == INPUT_STATE_JUST_BECAME_UP);
+    return button >= 0 && button < BUTTON_COUNT && mouse_just_up[button];
 }
 
 glm::vec2 Input::GetMousePosition() {
@@ -269,28 +323,25 @@ float Input::GetMouseScrollDelta() {
     return mouse_scroll_this_frame;
 }
 
+//The cursor belongs to the window, so it's changed from the render (main) thread
 void Input::HideCursor() {
-    SDL_ShowCursor(SDL_DISABLE);
+    FramePipeline::RunOnRenderThread([]() { SDL_ShowCursor(SDL_DISABLE); });
 }
 void Input::ShowCursor() {
-    SDL_ShowCursor(SDL_ENABLE);
+    FramePipeline::RunOnRenderThread([]() { SDL_ShowCursor(SDL_ENABLE); });
 
 }
 
 bool Input::GetControllerButton(int button) {
-	auto it = controller_states.find(button);
-	return (it != controller_states.end() &&
-		(it->second == INPUT_STATE_DOWN || it->second == INPUT_STATE_JUST_BECAME_DOWN));
+	return button >= 0 && button < BUTTON_COUNT && controller_held[button];
 }
 
 bool Input::GetControllerDown(int button) {
-	auto it = controller_states.find(static_cast<Uint8>(button));
-	return (it != controller_states.end() && it->second == INPUT_STATE_JUST_BECAME_DOWN);
+	return button >= 0 && button < BUTTON_COUNT && controller_just_down[button];
 }
 
 bool Input::GetControllerUp(int button) {
-	auto it = controller_states.find(button);
-	return (it != controller_states.end() && it->second == INPUT_STATE_JUST_BECAME_UP);
+	return button >= 0 && button < BUTTON_COUNT && controller_just_up[button];
 }
 
 glm::vec2 Input::GetControllerLeftStick() {
@@ -307,4 +358,9 @@ float Input::GetControllerLeftTrigger() {
 
 float Input::GetControllerRightTrigger() {
 	return controller_trigger_right;
+}
+
+float Input::GetControllerAxis(int axis) {
+	if (axis < 0 || axis >= SDL_CONTROLLER_AXIS_MAX) return 0.0f;
+	return controller_axes[axis];
 }
\ No newline at end of file
@@ -5,7 +5,9 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <bitset>
 #include "glm/glm.hpp"
+#include "lua/lua.hpp"
 
 enum INPUT_STATE { INPUT_STATE_UP, INPUT_STATE_JUST_BECAME_DOWN, INPUT_STATE_DOWN, INPUT_STATE_JUST_BECAME_UP };
 
@@ -19,6 +21,13 @@ public:
 	static bool GetKey(std::string keycode);
 	static bool GetKeyDown(std::string keycode);
 	static bool GetKeyUp(std::string keycode);
+	//Keycode names resolved ahead of time, for callers that cache the lookup
+	static SDL_Scancode GetScancode(const std::string& keycode);
+	static bool GetScancodeState(SDL_Scancode scancode);
+	static bool GetScancodeDown(SDL_Scancode scancode);
+	static bool GetScancodeUp(SDL_Scancode scancode);
+	//Publishes Input.Key, the keycode names as scancode integers scripts can pass instead of strings
+	static void RegisterKeyTable(lua_State* L);
 
 	static bool GetMouseButton(int button);
 	static bool GetMouseDown(int button);
@@ -37,25 +46,35 @@ public:
 	static glm::vec2 GetControllerRightStick();
 	static float GetControllerLeftTrigger();
 	static float GetControllerRightTrigger();
+	//Raw axis value in [-1, 1] with no dead zone, indexed by SDL_GameControllerAxis
+	static float GetControllerAxis(int axis);
+	//Fraction of full deflection the sticks ignore, 0 by default
+	static void SetDeadZone(float value) { stick_dead_zone = value; }
 
 private:
-	static std::unordered_map<SDL_Scancode, INPUT_STATE> keyboard_states;
-	static std::vector<SDL_Scancode> just_became_down_scancodes;
-	static std::vector<SDL_Scancode> just_became_up_scancodes;
-	static std::unordered_map<Uint8, INPUT_STATE> mouse_button_states;
-	static std::vector<Uint8> just_became_down_buttons;
-	static std::vector<Uint8> just_became_up_buttons;
+	//Buttons arrive as Uint8, so 256 covers every mouse and controller button SDL can report
+	static const int BUTTON_COUNT = 256;
+
+	//One bit per scancode/button. "held" is the steady state, the other two only last until LateUpdate
+	static std::bitset<SDL_NUM_SCANCODES> keys_held;
+	static std::bitset<SDL_NUM_SCANCODES> keys_just_down;
+	static std::bitset<SDL_NUM_SCANCODES> keys_just_up;
+	static std::bitset<BUTTON_COUNT> mouse_held;
+	static std::bitset<BUTTON_COUNT> mouse_just_down;
+	static std::bitset<BUTTON_COUNT> mouse_just_up;
 	static glm::vec2 mouse_position;
 	static float mouse_scroll_this_frame;
 
 	static SDL_GameController* controller;
-	static std::unordered_map<Uint8, INPUT_STATE> controller_states;
-	static std::vector<Uint8> just_became_down_controller;
-	static std::vector<Uint8> just_became_up_controller;
+	static std::bitset<BUTTON_COUNT> controller_held;
+	static std::bitset<BUTTON_COUNT> controller_just_down;
+	static std::bitset<BUTTON_COUNT> controller_just_up;
 	static glm::vec2 controller_left_stick;
 	static glm::vec2 controller_right_stick;
 	static float controller_trigger_left;
 	static float controller_trigger_right;
+	static float controller_axes[SDL_CONTROLLER_AXIS_MAX];
+	static float stick_dead_zone;
 };
 
 #endif
\ No newline at end of file
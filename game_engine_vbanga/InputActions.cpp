@@ -0,0 +1,291 @@
+#include "InputActions.h"
+#include "Input.h"
+#include "SceneDB.hpp"
+#include <iostream>
+#include <algorithm>
+
+std::vector<InputActions::Action> InputActions::actions;
+std::vector<InputActions::Axis> InputActions::axes;
+std::unordered_map<std::string, int> InputActions::action_ids;
+std::unordered_map<std::string, int> InputActions::axis_ids;
+float InputActions::default_dead_zone = 0.0f;
+
+//How far past its dead zone a stick has to be pushed before an "axis:" binding counts as pressed
+const float AXIS_PRESS_THRESHOLD = 0.5f;
+
+void InputActions::Load(const std::string& path) {
+	rapidjson::Document config;
+	ReadJsonFile(path, config);
+
+	if (config.HasMember("dead_zone")) {
+		default_dead_zone = config["dead_zone"].GetFloat();
+		//The legacy Input.GetController*Stick calls honour the same dead zone
+		Input::SetDeadZone(default_dead_zone);
+	}
+
+	if (config.HasMember("actions")) {
+		for (auto& member : config["actions"].GetObject()) {
+			Action action;
+			action.name = member.name.GetString();
+			CompileList(member.value, action.bindings, action.name);
+			action_ids[action.name] = static_cast<int>(actions.size());
+			actions.push_back(action);
+		}
+	}
+
+	if (config.HasMember("axes")) {
+		for (auto& member : config["axes"].GetObject()) {
+			Axis axis;
+			axis.name = member.name.GetString();
+			axis.dead_zone = default_dead_zone;
+			const rapidjson::Value& value = member.value;
+			if (value.HasMember("negative")) CompileList(value["negative"], axis.negative, axis.name);
+			if (value.HasMember("positive")) CompileList(value["positive"], axis.positive, axis.name);
+			if (value.HasMember("controller_axis")) {
+				SDL_GameControllerAxis controller_axis = SDL_GameControllerGetAxisFromString(value["controller_axis"].GetString());
+				if (controller_axis == SDL_CONTROLLER_AXIS_INVALID) {
+					std::cout << "error: input.config axis " << axis.name << " has unknown controller_axis " << value["controller_axis"].GetString();
+					exit(0);
+				}
+				axis.controller_axis = controller_axis;
+			}
+			if (value.HasMember("invert")) axis.inverted = value["invert"].GetBool();
+			if (value.HasMember("dead_zone")) axis.dead_zone = value["dead_zone"].GetFloat();
+			axis_ids[axis.name] = static_cast<int>(axes.size());
+			axes.push_back(axis);
+		}
+	}
+}
+
+void InputActions::CompileList(const rapidjson::Value& list, std::vector<Binding>& out, const std::string& owner) {
+	for (auto& entry : list.GetArray()) {
+		Binding binding;
+		if (!entry.IsString() || !ParseBinding(entry.GetString(), binding)) {
+			std::cout << "error: input.config binding for " << owner << " is not a key, mouse button, controller button or axis";
+			exit(0);
+		}
+		out.push_back(binding);
+	}
+}
+
+bool InputActions::ParseBinding(const std::string& text, Binding& out) {
+	if (text.rfind("mouse:", 0) == 0) {
+		out.source = SOURCE_MOUSE;
+		try {
+			out.code = std::stoi(text.substr(6));
+		}
+		catch (const std::exception&) {
+			return false;
+		}
+		return true;
+	}
+	if (text.rfind("controller:", 0) == 0) {
+		std::string name = text.substr(11);
+		out.source = SOURCE_CONTROLLER_BUTTON;
+		SDL_GameControllerButton button = SDL_GameControllerGetButtonFromString(name.c_str());
+		if (button != SDL_CONTROLLER_BUTTON_INVALID) {
+			out.code = button;
+			return true;
+		}
+		try {
+			out.code = std::stoi(name);
+		}
+		catch (const std::exception&) {
+			return false;
+		}
+		return true;
+	}
+	if (text.rfind("axis:", 0) == 0 && text.size() > 6) {
+		char direction = text.back();
+		if (direction != '+' && direction != '-') return false;
+		std::string name = text.substr(5, text.size() - 6);
+		SDL_GameControllerAxis axis = SDL_GameControllerGetAxisFromString(name.c_str());
+		if (axis == SDL_CONTROLLER_AXIS_INVALID) return false;
+		out.source = direction == '+' ? SOURCE_AXIS_POSITIVE : SOURCE_AXIS_NEGATIVE;
+		out.code = axis;
+		return true;
+	}
+	SDL_Scancode scancode = Input::GetScancode(text);
+	if (scancode == SDL_SCANCODE_UNKNOWN) return false;
+	out.source = SOURCE_KEY;
+	out.code = scancode;
+	return true;
+}
+
+float InputActions::ApplyDeadZone(float value, float dead_zone) {
+	float magnitude = std::abs(value);
+	if (magnitude <= dead_zone) return 0.0f;
+	if (dead_zone >= 1.0f) return 0.0f;
+	//Rescale so the output still starts at 0 right past the dead zone and reaches 1 at full tilt
+	float scaled = (magnitude - dead_zone) / (1.0f - dead_zone);
+	return value < 0 ? -scaled : scaled;
+}
+
+bool InputActions::IsActive(const Binding& binding, float dead_zone) {
+	switch (binding.source) {
+	case SOURCE_KEY:
+		return Input::GetScancodeState(static_cast<SDL_Scancode>(binding.code));
+	case SOURCE_MOUSE:
+		return Input::GetMouseButton(binding.code);
+	case SOURCE_CONTROLLER_BUTTON:
+		return Input::GetControllerButton(binding.code);
+	case SOURCE_AXIS_POSITIVE:
+		return ApplyDeadZone(Input::GetControllerAxis(binding.code), dead_zone) > AXIS_PRESS_THRESHOLD;
+	case SOURCE_AXIS_NEGATIVE:
+		return ApplyDeadZone(Input::GetControllerAxis(binding.code), dead_zone) < -AXIS_PRESS_THRESHOLD;
+	}
+	return false;
+}
+
+void InputActions::Update() {
+	for (Action& action : actions) {
+		bool was_held = action.held;
+		action.held = false;
+		for (const Binding& binding : action.bindings) {
+			if (IsActive(binding, default_dead_zone)) {
+				action.held = true;
+				break;
+			}
+		}
+		action.pressed = action.held && !was_held;
+		action.released = !action.held && was_held;
+	}
+
+	for (Axis& axis : axes) {
+		float value = 0.0f;
+		for (const Binding& binding : axis.positive) {
+			if (IsActive(binding, axis.dead_zone)) {
+				value += 1.0f;
+				break;
+			}
+		}
+		for (const Binding& binding : axis.negative) {
+			if (IsActive(binding, axis.dead_zone)) {
+				value -= 1.0f;
+				break;
+			}
+		}
+		if (axis.controller_axis >= 0) {
+			float stick = ApplyDeadZone(Input::GetControllerAxis(axis.controller_axis), axis.dead_zone);
+			value += axis.inverted ? -stick : stick;
+		}
+		axis.value = std::clamp(value, -1.0f, 1.0f);
+	}
+}
+
+void InputActions::RegisterTables(lua_State* L) {
+	lua_getglobal(L, "Input");
+	lua_createtable(L, 0, static_cast<int>(actions.size()));
+	for (size_t i = 0; i < actions.size(); i++) {
+		lua_pushinteger(L, static_cast<lua_Integer>(i));
+		lua_setfield(L, -2, actions[i].name.c_str());
+	}
+	lua_setfield(L, -2, "Action");
+	lua_createtable(L, 0, static_cast<int>(axes.size()));
+	for (size_t i = 0; i < axes.size(); i++) {
+		lua_pushinteger(L, static_cast<lua_Integer>(i));
+		lua_setfield(L, -2, axes[i].name.c_str());
+	}
+	lua_setfield(L, -2, "Axis");
+	lua_pop(L, 1);
+}
+
+int InputActions::CheckAction(lua_State* L, int index) {
+	if (lua_type(L, index) == LUA_TNUMBER) {
+		lua_Integer id = lua_tointeger(L, index);
+		luaL_argcheck(L, id >= 0 && id < static_cast<lua_Integer>(actions.size()), index, "unknown action id");
+		return static_cast<int>(id);
+	}
+	const char* name = luaL_checkstring(L, index);
+	auto it = action_ids.find(name);
+	if (it == action_ids.end()) luaL_error(L, "unknown input action %s", name);
+	return it->second;
+}
+
+int InputActions::CheckAxis(lua_State* L, int index) {
+	if (lua_type(L, index) == LUA_TNUMBER) {
+		lua_Integer id = lua_tointeger(L, index);
+		luaL_argcheck(L, id >= 0 && id < static_cast<lua_Integer>(axes.size()), index, "unknown axis id");
+		return static_cast<int>(id);
+	}
+	const char* name = luaL_checkstring(L, index);
+	auto it = axis_ids.find(name);
+	if (it == axis_ids.end()) luaL_error(L, "unknown input axis %s", name);
+	return it->second;
+}
+
+int InputActions::GetAction(lua_State* L) {
+	lua_pushboolean(L, actions[CheckAction(L, 1)].held);
+	return 1;
+}
+
+int InputActions::GetActionDown(lua_State* L) {
+	lua_pushboolean(L, actions[CheckAction(L, 1)].pressed);
+	return 1;
+}
+
+int InputActions::GetActionUp(lua_State* L) {
+	lua_pushboolean(L, actions[CheckAction(L, 1)].released);
+	return 1;
+}
+
+int InputActions::GetAxis(lua_State* L) {
+	lua_pushnumber(L, axes[CheckAxis(L, 1)].value);
+	return 1;
+}
+
+bool InputActions::CompileLuaList(lua_State* L, int index, std::vector<Binding>& out) {
+	luaL_checktype(L, index, LUA_TTABLE);
+	lua_Integer count = luaL_len(L, index);
+	for (lua_Integer i = 1; i <= count; i++) {
+		lua_geti(L, index, i);
+		Binding binding;
+		bool valid = lua_type(L, -1) == LUA_TSTRING && ParseBinding(lua_tostring(L, -1), binding);
+		lua_pop(L, 1);
+		if (!valid) return false;
+		out.push_back(binding);
+	}
+	return true;
+}
+
+int InputActions::RebindAction(lua_State* L) {
+	std::string name = luaL_checkstring(L, 1);
+	std::vector<Binding> bindings;
+	if (!CompileLuaList(L, 2, bindings)) {
+		return luaL_error(L, "RebindAction: a binding for %s is not a key, mouse button, controller button or axis", name.c_str());
+	}
+
+	auto it = action_ids.find(name);
+	if (it != action_ids.end()) {
+		actions[it->second].bindings = std::move(bindings);
+		return 0;
+	}
+
+	//A brand new action also gets an id in Input.Action
+	Action action;
+	action.name = name;
+	action.bindings = std::move(bindings);
+	int id = static_cast<int>(actions.size());
+	action_ids[name] = id;
+	actions.push_back(action);
+	lua_getglobal(L, "Input");
+	lua_getfield(L, -1, "Action");
+	if (lua_istable(L, -1)) {
+		lua_pushinteger(L, id);
+		lua_setfield(L, -2, name.c_str());
+	}
+	lua_pop(L, 2);
+	return 0;
+}
+
+int InputActions::RebindAxis(lua_State* L) {
+	int id = CheckAxis(L, 1);
+	std::vector<Binding> negative;
+	std::vector<Binding> positive;
+	if (!CompileLuaList(L, 2, negative) || !CompileLuaList(L, 3, positive)) {
+		return luaL_error(L, "RebindAxis: a binding for %s is not a key, mouse button, controller button or axis", axes[id].name.c_str());
+	}
+	axes[id].negative = std::move(negative);
+	axes[id].positive = std::move(positive);
+	return 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "lua/lua.hpp"
+#include "include/rapidjson/document.h"
+
+//Named actions and axes loaded from resources/input.config. Each binding string ("space", "mouse:1",
+//"controller:a", "axis:leftx+") is compiled once into a source and an index, so evaluating an action
+//is a few array reads, and Update() does that for every action once per frame right after the events
+//are polled. Scripts ask for actions by id (Input.Action.jump) or by name.
+class InputActions
+{
+private:
+	enum Source { SOURCE_KEY, SOURCE_MOUSE, SOURCE_CONTROLLER_BUTTON, SOURCE_AXIS_POSITIVE, SOURCE_AXIS_NEGATIVE };
+
+	struct Binding {
+		Source source;
+		int code;
+	};
+
+	struct Action {
+		std::string name;
+		std::vector<Binding> bindings;
+		bool held = false;
+		bool pressed = false;
+		bool released = false;
+	};
+
+	struct Axis {
+		std::string name;
+		std::vector<Binding> negative;
+		std::vector<Binding> positive;
+		int controller_axis = -1; //SDL_GameControllerAxis, -1 for keys only
+		bool inverted = false;
+		float dead_zone = 0.0f;
+		float value = 0.0f;
+	};
+
+	static std::vector<Action> actions;
+	static std::vector<Axis> axes;
+	static std::unordered_map<std::string, int> action_ids;
+	static std::unordered_map<std::string, int> axis_ids;
+	static float default_dead_zone;
+
+	static bool ParseBinding(const std::string& text, Binding& out);
+	static bool IsActive(const Binding& binding, float dead_zone);
+	static float ApplyDeadZone(float value, float dead_zone);
+	static void CompileList(const rapidjson::Value& list, std::vector<Binding>& out, const std::string& owner);
+	static bool CompileLuaList(lua_State* L, int index, std::vector<Binding>& out);
+	static int CheckAction(lua_State* L, int index);
+	static int CheckAxis(lua_State* L, int index);
+public:
+	static void Load(const std::string& path);
+	static void Update();
+	static void RegisterTables(lua_State* L);
+
+	//Lua API, registered under Input
+	static int GetAction(lua_State* L);
+	static int GetActionDown(lua_State* L);
+	static int GetActionUp(lua_State* L);
+	static int GetAxis(lua_State* L);
+	static int RebindAction(lua_State* L);
+	static int RebindAxis(lua_State* L);
+};
@@ -0,0 +1,69 @@
+#include "InputHooks.h"
+#include "ActorDB.h"
+#include "CoroutineScheduler.h"
+#include <algorithm>
+
+const char* const InputHooks::hook_names[HOOK_COUNT] = {
+	"OnKeyDown", "OnKeyUp", "OnMouseDown", "OnMouseUp", "OnControllerButton"
+};
+std::vector<InputHooks::Listener> InputHooks::listeners[HOOK_COUNT];
+std::vector<InputHooks::Event> InputHooks::events;
+
+void InputHooks::Register(ActorDB* owner, const std::string& key, luabridge::LuaRef component) {
+	if (!component.isTable()) return;
+	for (int hook = 0; hook < HOOK_COUNT; hook++) {
+		if (component[hook_names[hook]].isFunction()) {
+			listeners[hook].push_back({ owner, key, component });
+		}
+	}
+}
+
+void InputHooks::Unregister(ActorDB* owner, const std::string& key) {
+	for (auto& list : listeners) {
+		if (list.empty()) continue;
+		list.erase(std::remove_if(list.begin(), list.end(), [&](const Listener& listener) {
+			return listener.owner == owner && listener.key == key;
+			}), list.end());
+	}
+}
+
+void InputHooks::UnregisterAll(ActorDB* owner) {
+	for (auto& list : listeners) {
+		if (list.empty()) continue;
+		list.erase(std::remove_if(list.begin(), list.end(), [&](const Listener& listener) {
+			return listener.owner == owner;
+			}), list.end());
+	}
+}
+
+void InputHooks::Dispatch() {
+	if (events.empty()) return;
+
+	for (const Event& event : events) {
+		const char* hook_name = hook_names[event.hook];
+		//Actor.Instantiate registers new listeners straight away, so walk by index and only up to
+		//the listeners that were there when the event started
+		size_t count = listeners[event.hook].size();
+		for (size_t i = 0; i < count; i++) {
+			ActorDB* owner = listeners[event.hook][i].owner;
+			luabridge::LuaRef component = listeners[event.hook][i].component;
+			if (owner->getDelete()) continue;
+			if (component["enabled"].isBool() && !component["enabled"]) continue;
+
+			CoroutineScheduler::SetOwner(owner);
+			try {
+				if (event.hook == HOOK_CONTROLLER_BUTTON) {
+					component[hook_name](component, event.code, event.pressed);
+				}
+				else {
+					component[hook_name](component, event.code);
+				}
+			}
+			catch (luabridge::LuaException const& e) {
+				ReportError(owner->getName(), e);
+			}
+		}
+	}
+	CoroutineScheduler::SetOwner(nullptr);
+	events.clear();
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "lua/lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+
+class ActorDB;
+
+//Pushes input to the components that ask for it instead of having every component poll.
+//A component that defines OnKeyDown(self, key), OnKeyUp(self, key), OnMouseDown(self, button),
+//OnMouseUp(self, button) or OnControllerButton(self, button, pressed) is put on that hook's
+//listener list when it is added to its actor, and Dispatch() calls those lists only for the
+//events that actually arrived this frame. Keys are scancodes, the same numbers as Input.Key.
+class InputHooks
+{
+public:
+	enum Hook { HOOK_KEY_DOWN, HOOK_KEY_UP, HOOK_MOUSE_DOWN, HOOK_MOUSE_UP, HOOK_CONTROLLER_BUTTON, HOOK_COUNT };
+
+private:
+	struct Listener {
+		ActorDB* owner;
+		std::string key;
+		luabridge::LuaRef component;
+	};
+
+	struct Event {
+		Hook hook;
+		int code;
+		bool pressed;
+	};
+
+	static const char* const hook_names[HOOK_COUNT];
+	static std::vector<Listener> listeners[HOOK_COUNT];
+	static std::vector<Event> events;
+public:
+	static void Register(ActorDB* owner, const std::string& key, luabridge::LuaRef component);
+	static void Unregister(ActorDB* owner, const std::string& key);
+	static void UnregisterAll(ActorDB* owner);
+	static bool HasListeners(Hook hook) { return !listeners[hook].empty(); }
+	static void Queue(Hook hook, int code, bool pressed) { events.push_back({ hook, code, pressed }); }
+	static void Dispatch();
+};
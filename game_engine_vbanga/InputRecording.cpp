@@ -0,0 +1,291 @@
+#include "InputRecording.h"
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FILE* InputRecording::record_file = nullptr;
+std::vector<char> InputRecording::write_buffer;
+std::vector<InputRecording::EventRecord> InputRecording::pending_events;
+std::mutex InputRecording::pending_mutex;
+std::vector<InputRecording::IndexEntry> InputRecording::written_index;
+uint64_t InputRecording::write_offset = 0;
+int InputRecording::recording_frame = -1;
+
+const char* InputRecording::mapped_data = nullptr;
+size_t InputRecording::mapped_size = 0;
+const InputRecording::IndexEntry* InputRecording::replay_index = nullptr;
+size_t InputRecording::replay_index_count = 0;
+std::vector<InputRecording::IndexEntry> InputRecording::scanned_index;
+size_t InputRecording::replay_cursor = 0;
+int InputRecording::replay_last_frame = -1;
+int InputRecording::last_pushed_frame = -1;
+
+const char RECORDING_MAGIC[4] = { 'V', 'A', 'I', 'R' };
+const char INDEX_MAGIC[4] = { 'V', 'A', 'I', 'X' };
+const uint32_t RECORDING_VERSION = 1;
+const size_t FILE_HEADER_SIZE = 8;
+const size_t WRITE_BUFFER_FLUSH_SIZE = 64 * 1024;
+
+#ifdef _WIN32
+static HANDLE mapping_file = INVALID_HANDLE_VALUE;
+static HANDLE mapping_handle = nullptr;
+#endif
+
+void InputRecording::StartRecording(const std::string& path) {
+	if (record_file) return;
+	record_file = std::fopen(path.c_str(), "wb");
+	if (!record_file) {
+		std::cerr << "Error : Failed to open " << path << " for writing." << std::endl;
+		return;
+	}
+
+	write_buffer.reserve(WRITE_BUFFER_FLUSH_SIZE * 2);
+	pending_events.reserve(128);
+	uint32_t version = RECORDING_VERSION;
+	Write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+	Write(&version, sizeof(version));
+
+	//Events are captured as SDL queues them, so there is no per-frame peek of the event queue
+	SDL_AddEventWatch(RecordWatch, nullptr);
+}
+
+int SDLCALL InputRecording::RecordWatch(void*, SDL_Event* e) {
+	EventRecord record{ e->type, 0, 0, 0.0f };
+	switch (e->type) {
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+		record.a = static_cast<int32_t>(e->key.keysym.scancode);
+		//Input tells key presses from auto-repeats by this, so a held key has to replay the same way
+		record.b = e->key.repeat;
+		break;
+	case SDL_MOUSEMOTION:
+		record.a = e->motion.x;
+		record.b = e->motion.y;
+		break;
+	case SDL_MOUSEBUTTONDOWN:
+	case SDL_MOUSEBUTTONUP:
+		record.a = static_cast<int32_t>(e->button.button);
+		break;
+	case SDL_MOUSEWHEEL:
+		record.f = e->wheel.preciseY;
+		break;
+	case SDL_QUIT:
+		break;
+	default:
+		return 1;
+	}
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	pending_events.push_back(record);
+	return 1;
+}
+
+void InputRecording::BeginFrame(int frame) {
+	//Called on every poll, but only the first poll of a frame closes out the previous one
+	if (frame == recording_frame) return;
+	CommitPendingFrame();
+	recording_frame = frame;
+}
+
+void InputRecording::CommitPendingFrame() {
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	if (pending_events.empty()) return;
+	BlockHeader block{ static_cast<uint32_t>(std::max(recording_frame, 0)), static_cast<uint32_t>(pending_events.size()) };
+	Write(&block, sizeof(block));
+	written_index.push_back({ block.frame, block.count, write_offset });
+	Write(pending_events.data(), pending_events.size() * sizeof(EventRecord));
+	pending_events.clear();
+	if (write_buffer.size() >= WRITE_BUFFER_FLUSH_SIZE) {
+		FlushWriteBuffer();
+	}
+}
+
+void InputRecording::Write(const void* data, size_t size) {
+	const char* bytes = static_cast<const char*>(data);
+	write_buffer.insert(write_buffer.end(), bytes, bytes + size);
+	write_offset += size;
+}
+
+void InputRecording::FlushWriteBuffer() {
+	if (!write_buffer.empty()) {
+		std::fwrite(write_buffer.data(), 1, write_buffer.size(), record_file);
+		write_buffer.clear();
+	}
+}
+
+void InputRecording::Shutdown() {
+	if (!record_file) return;
+	SDL_DelEventWatch(RecordWatch, nullptr);
+	CommitPendingFrame();
+
+	Footer footer{};
+	footer.index_offset = write_offset;
+	footer.index_count = static_cast<uint32_t>(written_index.size());
+	footer.last_frame = static_cast<uint32_t>(std::max(recording_frame, 0));
+	std::memcpy(footer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	Write(written_index.data(), written_index.size() * sizeof(IndexEntry));
+	Write(&footer, sizeof(footer));
+
+	FlushWriteBuffer();
+	std::fclose(record_file);
+	record_file = nullptr;
+}
+
+bool InputRecording::OpenReplay(const std::string& path) {
+	if (!MapFile(path)) return false;
+	if (mapped_size < FILE_HEADER_SIZE || std::memcmp(mapped_data, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0) {
+		std::cerr << "Error : " << path << " is not an input recording." << std::endl;
+		UnmapFile();
+		return false;
+	}
+	if (!BuildIndex()) {
+		std::cerr << "Error : " << path << " is corrupt." << std::endl;
+		UnmapFile();
+		return false;
+	}
+	replay_cursor = 0;
+	last_pushed_frame = -1;
+	return true;
+}
+
+bool InputRecording::BuildIndex() {
+	//A clean recording ends with its own index, which is used straight out of the mapping
+	if (mapped_size >= FILE_HEADER_SIZE + sizeof(Footer)) {
+		Footer footer;
+		std::memcpy(&footer, mapped_data + mapped_size - sizeof(Footer), sizeof(Footer));
+		uint64_t index_bytes = static_cast<uint64_t>(footer.index_count) * sizeof(IndexEntry);
+		if (std::memcmp(footer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0
+			&& footer.index_offset + index_bytes + sizeof(Footer) == mapped_size) {
+			replay_index = reinterpret_cast<const IndexEntry*>(mapped_data + footer.index_offset);
+			replay_index_count = footer.index_count;
+			replay_last_frame = static_cast<int>(footer.last_frame);
+			return true;
+		}
+	}
+
+	//Otherwise the session didn't shut down cleanly, so walk the blocks and keep every complete one
+	scanned_index.clear();
+	size_t offset = FILE_HEADER_SIZE;
+	while (offset + sizeof(BlockHeader) <= mapped_size) {
+		BlockHeader block;
+		std::memcpy(&block, mapped_data + offset, sizeof(block));
+		size_t records_offset = offset + sizeof(BlockHeader);
+		size_t records_size = static_cast<size_t>(block.count) * sizeof(EventRecord);
+		if (records_offset + records_size > mapped_size) break;
+		if (!scanned_index.empty() && block.frame <= scanned_index.back().frame) break;
+		scanned_index.push_back({ block.frame, block.count, records_offset });
+		offset = records_offset + records_size;
+	}
+	replay_index = scanned_index.data();
+	replay_index_count = scanned_index.size();
+	replay_last_frame = scanned_index.empty() ? 0 : static_cast<int>(scanned_index.back().frame);
+	return offset > FILE_HEADER_SIZE || mapped_size == FILE_HEADER_SIZE;
+}
+
+void InputRecording::PushFrameEvents(int frame) {
+	if (frame == last_pushed_frame) return;
+	last_pushed_frame = frame;
+
+	while (replay_cursor < replay_index_count && replay_index[replay_cursor].frame < static_cast<uint32_t>(frame)) {
+		replay_cursor++;
+	}
+	if (replay_cursor == replay_index_count || replay_index[replay_cursor].frame != static_cast<uint32_t>(frame)) return;
+
+	const IndexEntry& entry = replay_index[replay_cursor];
+	const char* records = mapped_data + entry.offset;
+	for (uint32_t i = 0; i < entry.count; i++) {
+		EventRecord record;
+		std::memcpy(&record, records + i * sizeof(EventRecord), sizeof(EventRecord));
+
+		SDL_Event fabricated_sdl_event{};
+		fabricated_sdl_event.type = record.type;
+		switch (record.type) {
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+			fabricated_sdl_event.key.keysym.scancode = static_cast<SDL_Scancode>(record.a);
+			fabricated_sdl_event.key.repeat = static_cast<Uint8>(record.b);
+			break;
+		case SDL_MOUSEMOTION:
+			fabricated_sdl_event.motion.x = record.a;
+			fabricated_sdl_event.motion.y = record.b;
+			break;
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+			fabricated_sdl_event.button.button = static_cast<Uint8>(record.a);
+			break;
+		case SDL_MOUSEWHEEL:
+			fabricated_sdl_event.wheel.preciseY = record.f;
+			break;
+		default:
+			break;
+		}
+		SDL_PushEvent(&fabricated_sdl_event);
+	}
+	replay_cursor++;
+}
+
+bool InputRecording::MapFile(const std::string& path) {
+#ifdef _WIN32
+	mapping_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mapping_file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mapping_file, &size) || size.QuadPart == 0) {
+		CloseHandle(mapping_file);
+		mapping_file = INVALID_HANDLE_VALUE;
+		return false;
+	}
+	mapping_handle = CreateFileMappingA(mapping_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping_handle) {
+		CloseHandle(mapping_file);
+		mapping_file = INVALID_HANDLE_VALUE;
+		return false;
+	}
+	mapped_data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	mapped_size = static_cast<size_t>(size.QuadPart);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) return false;
+	//Replay reads the file front to back exactly once
+	madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+	mapped_data = static_cast<const char*>(data);
+	mapped_size = static_cast<size_t>(info.st_size);
+#endif
+	if (!mapped_data) {
+		UnmapFile();
+		return false;
+	}
+	return true;
+}
+
+void InputRecording::UnmapFile() {
+#ifdef _WIN32
+	if (mapped_data) UnmapViewOfFile(mapped_data);
+	if (mapping_handle) CloseHandle(mapping_handle);
+	if (mapping_file != INVALID_HANDLE_VALUE) CloseHandle(mapping_file);
+	mapping_handle = nullptr;
+	mapping_file = INVALID_HANDLE_VALUE;
+#else
+	if (mapped_data) munmap(const_cast<char*>(mapped_data), mapped_size);
+#endif
+	mapped_data = nullptr;
+	mapped_size = 0;
+	replay_index = nullptr;
+	replay_index_count = 0;
+}
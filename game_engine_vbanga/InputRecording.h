@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "SDL.h"
+
+//Binary input recording. The file is a small header followed by append-only frame blocks
+//(frame number, event count, fixed-size event records), and on a clean shutdown a frame index
+//table and footer are appended. Replay maps the file read-only and walks the index, so nothing
+//is parsed up front; a recording cut short by a crash is still replayable by scanning the blocks.
+class InputRecording
+{
+private:
+	//Keys: a is the scancode and b the repeat flag. Mouse motion: a and b are x and y.
+	//Mouse buttons: a is the button. Mouse wheel: f is preciseY.
+	struct EventRecord {
+		uint32_t type;
+		int32_t a;
+		int32_t b;
+		float f;
+	};
+	struct BlockHeader {
+		uint32_t frame;
+		uint32_t count;
+	};
+	struct IndexEntry {
+		uint32_t frame;
+		uint32_t count;
+		uint64_t offset;
+	};
+	struct Footer {
+		uint64_t index_offset;
+		uint32_t index_count;
+		uint32_t last_frame;
+		char magic[4];
+		uint32_t padding;
+	};
+
+	//Recording
+	static FILE* record_file;
+	static std::vector<char> write_buffer;
+	static std::vector<EventRecord> pending_events;
+	//The event watch runs on whichever thread pushes the event, not necessarily the one committing frames
+	static std::mutex pending_mutex;
+	static std::vector<IndexEntry> written_index;
+	static uint64_t write_offset;
+	static int recording_frame;
+
+	//Replay
+	static const char* mapped_data;
+	static size_t mapped_size;
+	static const IndexEntry* replay_index;
+	static size_t replay_index_count;
+	static std::vector<IndexEntry> scanned_index;
+	static size_t replay_cursor;
+	static int replay_last_frame;
+	static int last_pushed_frame;
+
+	static int SDLCALL RecordWatch(void*, SDL_Event* e);
+	static void CommitPendingFrame();
+	static void Write(const void* data, size_t size);
+	static void FlushWriteBuffer();
+	static bool MapFile(const std::string& path);
+	static void UnmapFile();
+	static bool BuildIndex();
+public:
+	static bool OpenReplay(const std::string& path);
+	static bool IsReplaying() { return mapped_data != nullptr; }
+	static void PushFrameEvents(int frame);
+	static bool IsFinished(int frame) { return frame > replay_last_frame; }
+
+	static void StartRecording(const std::string& path);
+	static bool IsRecording() { return record_file != nullptr; }
+	static void BeginFrame(int frame);
+	static void Shutdown();
+};
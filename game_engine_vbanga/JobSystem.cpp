@@ -0,0 +1,200 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+
+std::vector<JobSystem::WorkerQueue*> JobSystem::queues;
+std::vector<std::thread> JobSystem::threads;
+std::mutex JobSystem::main_mutex;
+std::vector<JobSystem::QueuedJob> JobSystem::main_jobs;
+std::mutex JobSystem::sleep_mutex;
+std::condition_variable JobSystem::work_available;
+std::atomic<int> JobSystem::queued(0);
+std::atomic<size_t> JobSystem::next_queue(0);
+std::thread::id JobSystem::main_thread_id = std::this_thread::get_id();
+bool JobSystem::stopping = false;
+
+//Which queue the current thread owns; -1 on the main thread and anything else outside the pool
+static thread_local int worker_index = -1;
+
+void JobSystem::Init(int worker_count) {
+	if (!queues.empty()) return;
+	main_thread_id = std::this_thread::get_id();
+	worker_count = std::max(0, std::min(worker_count, 64));
+
+	//With no workers there is still one queue, which waiting threads drain themselves
+	int queue_count = std::max(worker_count, 1);
+	for (int i = 0; i < queue_count; i++) {
+		queues.push_back(new WorkerQueue());
+	}
+	stopping = false;
+	for (int i = 0; i < worker_count; i++) {
+		threads.emplace_back(&JobSystem::WorkerLoop, i);
+	}
+}
+
+void JobSystem::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping = true;
+	}
+	work_available.notify_all();
+	for (std::thread& thread : threads) {
+		if (thread.joinable()) thread.join();
+	}
+	threads.clear();
+}
+
+void JobSystem::Submit(Job job, JobCounter* counter) {
+	if (counter) counter->remaining.fetch_add(1, std::memory_order_relaxed);
+	Enqueue({ std::move(job), counter });
+}
+
+void JobSystem::SubmitAfter(JobCounter* dependency, Job job, JobCounter* counter) {
+	if (counter) counter->remaining.fetch_add(1, std::memory_order_relaxed);
+	if (dependency) {
+		std::unique_lock<std::mutex> lock(dependency->continuation_mutex);
+		//Checked under the lock so Finish() can't empty the list between the check and the push
+		if (dependency->remaining.load(std::memory_order_acquire) != 0) {
+			dependency->continuations.emplace_back(std::move(job), counter);
+			return;
+		}
+	}
+	Enqueue({ std::move(job), counter });
+}
+
+void JobSystem::SubmitMain(Job job, JobCounter* counter) {
+	if (counter) counter->remaining.fetch_add(1, std::memory_order_relaxed);
+	std::lock_guard<std::mutex> lock(main_mutex);
+	main_jobs.push_back({ std::move(job), counter });
+}
+
+void JobSystem::PumpMain() {
+	if (!IsMainThread()) return;
+	std::vector<QueuedJob> jobs;
+	{
+		std::lock_guard<std::mutex> lock(main_mutex);
+		if (main_jobs.empty()) return;
+		jobs.swap(main_jobs);
+	}
+	for (QueuedJob& job : jobs) {
+		Execute(job);
+	}
+}
+
+void JobSystem::Wait(JobCounter* counter) {
+	if (!counter) return;
+	while (!counter->IsDone()) {
+		if (IsMainThread()) PumpMain();
+		if (!TryRunOne(worker_index)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+	if (count == 0) return;
+	grain = std::max<size_t>(grain, 1);
+	if (threads.empty() || count <= grain) {
+		body(0, count);
+		return;
+	}
+
+	//A few chunks per thread so a slow chunk doesn't leave the rest idle, but never below grain
+	size_t thread_count = threads.size() + 1;
+	size_t chunk = std::max(grain, (count + thread_count * 4 - 1) / (thread_count * 4));
+	JobCounter counter;
+	for (size_t begin = chunk; begin < count; begin += chunk) {
+		size_t end = std::min(begin + chunk, count);
+		Submit([&body, begin, end]() { body(begin, end); }, &counter);
+	}
+	body(0, std::min(chunk, count));
+	Wait(&counter);
+}
+
+void JobSystem::Enqueue(QueuedJob job) {
+	if (queues.empty()) {
+		//Not initialized (tools, tests): there is nowhere to queue it, so just run it
+		Execute(job);
+		return;
+	}
+
+	WorkerQueue* queue = worker_index >= 0 ? queues[worker_index] : queues[next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size()];
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back(std::move(job));
+	}
+	queued.fetch_add(1, std::memory_order_release);
+	{
+		//Taking the lock orders this against a worker that has just checked queued and is about to sleep
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+	}
+	work_available.notify_one();
+}
+
+bool JobSystem::TryRunOne(int home) {
+	if (queued.load(std::memory_order_acquire) == 0) return false;
+
+	size_t queue_count = queues.size();
+	size_t start = home >= 0 ? static_cast<size_t>(home) : 0;
+	for (size_t i = 0; i < queue_count; i++) {
+		WorkerQueue* queue = queues[(start + i) % queue_count];
+		QueuedJob job;
+		{
+			std::lock_guard<std::mutex> lock(queue->mutex);
+			if (queue->jobs.empty()) continue;
+			//Newest first from our own queue (its data is likely still in cache), oldest first when stealing
+			if (home >= 0 && i == 0) {
+				job = std::move(queue->jobs.back());
+				queue->jobs.pop_back();
+			}
+			else {
+				job = std::move(queue->jobs.front());
+				queue->jobs.pop_front();
+			}
+		}
+		queued.fetch_sub(1, std::memory_order_relaxed);
+		Execute(job);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::Execute(QueuedJob& job) {
+	{
+		PROFILE_SCOPE("Job");
+		int previous_tag = AllocTracker::GetCurrentTag();
+		AllocTracker::SetCurrentTag(job.alloc_tag);
+		job.job();
+		AllocTracker::SetCurrentTag(previous_tag);
+	}
+	Finish(job.counter);
+}
+
+void JobSystem::Finish(JobCounter* counter) {
+	if (!counter) return;
+	counter->finishing.fetch_add(1, std::memory_order_relaxed);
+
+	//If that was the last job, release anything that was waiting on this counter
+	std::vector<std::pair<Job, JobCounter*>> continuations;
+	if (counter->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		std::lock_guard<std::mutex> lock(counter->continuation_mutex);
+		continuations.swap(counter->continuations);
+	}
+	//Last touch of the counter
+	counter->finishing.fetch_sub(1, std::memory_order_release);
+	for (std::pair<Job, JobCounter*>& continuation : continuations) {
+		Enqueue({ std::move(continuation.first), continuation.second });
+	}
+}
+
+void JobSystem::WorkerLoop(int index) {
+	worker_index = index;
+	Profiler::SetThreadName("job worker");
+	while (true) {
+		if (TryRunOne(index)) continue;
+
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		work_available.wait(lock, [] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+		if (stopping && queued.load(std::memory_order_acquire) == 0) return;
+	}
+}
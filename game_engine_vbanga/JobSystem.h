@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include "AllocTracker.h"
+
+//Engine-wide pool of worker threads. Each worker has its own deque: it takes jobs from the back
+//of its own and, when that runs dry, steals from the front of the others', so a burst of jobs
+//submitted from one place still spreads across every core.
+//
+//Jobs are tracked with a JobCounter, which counts the jobs submitted against it that haven't
+//finished. Wait() on a counter runs queued jobs on the waiting thread until the counter is done,
+//so waiting never idles a core and works even with no workers at all. A job can be held back
+//until another counter is done (SubmitAfter), which is how dependent work is chained.
+//
+//SDL (and anything else that has to stay on the main thread) goes through SubmitMain(); those
+//jobs run when the main thread calls PumpMain(), once a frame and while it waits on a counter.
+class JobSystem
+{
+public:
+	using Job = std::function<void()>;
+
+	class JobCounter {
+		friend class JobSystem;
+		std::atomic<int> remaining{ 0 };
+		//Jobs still inside Finish(); a waiter may destroy the counter once this is back to zero
+		std::atomic<int> finishing{ 0 };
+		std::mutex continuation_mutex;
+		std::vector<std::pair<Job, JobCounter*>> continuations;
+	public:
+		bool IsDone() const { return remaining.load(std::memory_order_acquire) == 0 && finishing.load(std::memory_order_acquire) == 0; }
+	};
+private:
+	struct QueuedJob {
+		Job job;
+		JobCounter* counter;
+		//Allocations made by the job are counted against whoever submitted it
+		int alloc_tag = AllocTracker::GetCurrentTag();
+	};
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<QueuedJob> jobs;
+	};
+
+	static std::vector<WorkerQueue*> queues;
+	static std::vector<std::thread> threads;
+	static std::mutex main_mutex;
+	static std::vector<QueuedJob> main_jobs;
+	static std::mutex sleep_mutex;
+	static std::condition_variable work_available;
+	static std::atomic<int> queued;
+	static std::atomic<size_t> next_queue;
+	static std::thread::id main_thread_id;
+	static bool stopping;
+
+	static void WorkerLoop(int index);
+	static void Enqueue(QueuedJob job);
+	static bool TryRunOne(int home);
+	static void Execute(QueuedJob& job);
+	static void Finish(JobCounter* counter);
+public:
+	static void Init(int worker_count);
+	static void Shutdown();
+	static int GetWorkerCount() { return static_cast<int>(threads.size()); }
+	static bool IsMainThread() { return std::this_thread::get_id() == main_thread_id; }
+
+	static void Submit(Job job, JobCounter* counter = nullptr);
+	static void SubmitAfter(JobCounter* dependency, Job job, JobCounter* counter = nullptr);
+	static void SubmitMain(Job job, JobCounter* counter = nullptr);
+	static void PumpMain();
+	static void Wait(JobCounter* counter);
+
+	//Calls body(begin, end) over [0, count) in chunks of at least grain and returns once all are done.
+	//Small ranges, and everything when there are no workers, run inline on the calling thread.
+	static void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+};
@@ -0,0 +1,194 @@
+#include "LuaFastBindings.h"
+#include "ImageDB.h"
+#include "TextDB.h"
+#include "AudioDB.h"
+#include "Input.h"
+#include "Helper.h"
+
+static NameCache<SDL_Texture*> image_cache;
+static NameCache<TTF_Font*> font_cache;
+static NameCache<Mix_Chunk*> audio_cache;
+static NameCache<SDL_Scancode> scancode_cache;
+
+//Same errors luabridge gives for a bad argument, without going through its Stack<> templates
+static inline float CheckFloat(lua_State* L, int index) {
+	int is_number = 0;
+	lua_Number value = lua_tonumberx(L, index, &is_number);
+	if (!is_number) luaL_typeerror(L, index, "number");
+	return static_cast<float>(value);
+}
+
+static inline int CheckInt(lua_State* L, int index) {
+	return static_cast<int>(luaL_checkinteger(L, index));
+}
+
+static SDL_Texture* CheckImage(lua_State* L, int index) {
+	size_t length = 0;
+	const char* name = luaL_checklstring(L, index, &length);
+	return image_cache.Get(name, length, 0, [](const std::string& image_name, int) {
+		return ImageDB::LoadImage(image_name);
+		});
+}
+
+static SDL_Scancode CheckScancode(lua_State* L, int index) {
+	//Input.Key constants are already scancodes, so that case is a single read
+	if (lua_type(L, index) == LUA_TNUMBER) {
+		return static_cast<SDL_Scancode>(lua_tointeger(L, index));
+	}
+	size_t length = 0;
+	const char* keycode = luaL_checklstring(L, index, &length);
+	return scancode_cache.Get(keycode, length, 0, [](const std::string& name, int) {
+		return Input::GetScancode(name);
+		});
+}
+
+int LuaFastBindings::ImageDraw(lua_State* L) {
+	SDL_Texture* texture = CheckImage(L, 1);
+	ImageDB::DrawTexture(texture, CheckFloat(L, 2), CheckFloat(L, 3));
+	return 0;
+}
+
+int LuaFastBindings::ImageDrawEx(lua_State* L) {
+	SDL_Texture* texture = CheckImage(L, 1);
+	float x = CheckFloat(L, 2);
+	float y = CheckFloat(L, 3);
+	float rotation_degrees = CheckFloat(L, 4);
+	float scale_x = CheckFloat(L, 5);
+	float scale_y = CheckFloat(L, 6);
+	float pivot_x = CheckFloat(L, 7);
+	float pivot_y = CheckFloat(L, 8);
+	float r = CheckFloat(L, 9);
+	float g = CheckFloat(L, 10);
+	float b = CheckFloat(L, 11);
+	float a = CheckFloat(L, 12);
+	float sorting_order = CheckFloat(L, 13);
+	ImageDB::DrawTextureEx(texture, x, y, rotation_degrees, scale_x, scale_y, pivot_x, pivot_y, r, g, b, a, sorting_order);
+	return 0;
+}
+
+int LuaFastBindings::ImageDrawUI(lua_State* L) {
+	SDL_Texture* texture = CheckImage(L, 1);
+	ImageDB::DrawUITexture(texture, CheckFloat(L, 2), CheckFloat(L, 3));
+	return 0;
+}
+
+int LuaFastBindings::ImageDrawUIEx(lua_State* L) {
+	SDL_Texture* texture = CheckImage(L, 1);
+	float x = CheckFloat(L, 2);
+	float y = CheckFloat(L, 3);
+	float r = CheckFloat(L, 4);
+	float g = CheckFloat(L, 5);
+	float b = CheckFloat(L, 6);
+	float a = CheckFloat(L, 7);
+	float sorting_order = CheckFloat(L, 8);
+	ImageDB::DrawUITextureEx(texture, x, y, r, g, b, a, sorting_order);
+	return 0;
+}
+
+int LuaFastBindings::ImageDrawPixel(lua_State* L) {
+	float x = CheckFloat(L, 1);
+	float y = CheckFloat(L, 2);
+	float r = CheckFloat(L, 3);
+	float g = CheckFloat(L, 4);
+	float b = CheckFloat(L, 5);
+	float a = CheckFloat(L, 6);
+	ImageDB::DrawPixel(x, y, r, g, b, a);
+	return 0;
+}
+
+int LuaFastBindings::TextDraw(lua_State* L) {
+	const char* content = luaL_checkstring(L, 1);
+	float x = CheckFloat(L, 2);
+	float y = CheckFloat(L, 3);
+	size_t font_length = 0;
+	const char* font_name = luaL_checklstring(L, 4, &font_length);
+	int font_size = CheckInt(L, 5);
+	int r = CheckInt(L, 6);
+	int g = CheckInt(L, 7);
+	int b = CheckInt(L, 8);
+	int a = CheckInt(L, 9);
+	if (content[0] == '\0') return 0;
+
+	TTF_Font* font = font_cache.Get(font_name, font_length, font_size, [](const std::string& name, int size) {
+		return TextDB::GetFont(name, size);
+		});
+	TextDB::DrawTextWithFont(content, x, y, font, r, g, b, a);
+	return 0;
+}
+
+int LuaFastBindings::InputGetKey(lua_State* L) {
+	lua_pushboolean(L, Input::GetScancodeState(CheckScancode(L, 1)));
+	return 1;
+}
+
+int LuaFastBindings::InputGetKeyDown(lua_State* L) {
+	lua_pushboolean(L, Input::GetScancodeDown(CheckScancode(L, 1)));
+	return 1;
+}
+
+int LuaFastBindings::InputGetKeyUp(lua_State* L) {
+	lua_pushboolean(L, Input::GetScancodeUp(CheckScancode(L, 1)));
+	return 1;
+}
+
+int LuaFastBindings::InputGetMouseButton(lua_State* L) {
+	lua_pushboolean(L, Input::GetMouseButton(CheckInt(L, 1)));
+	return 1;
+}
+
+int LuaFastBindings::InputGetMouseButtonDown(lua_State* L) {
+	lua_pushboolean(L, Input::GetMouseDown(CheckInt(L, 1)));
+	return 1;
+}
+
+int LuaFastBindings::InputGetMouseButtonUp(lua_State* L) {
+	lua_pushboolean(L, Input::GetMouseUp(CheckInt(L, 1)));
+	return 1;
+}
+
+int LuaFastBindings::InputGetMouseScrollDelta(lua_State* L) {
+	lua_pushnumber(L, Input::GetMouseScrollDelta());
+	return 1;
+}
+
+int LuaFastBindings::CameraSetPosition(lua_State* L) {
+	ImageDB::setCamera(CheckFloat(L, 1), CheckFloat(L, 2));
+	return 0;
+}
+
+int LuaFastBindings::CameraGetPositionX(lua_State* L) {
+	lua_pushnumber(L, ImageDB::getPositionX());
+	return 1;
+}
+
+int LuaFastBindings::CameraGetPositionY(lua_State* L) {
+	lua_pushnumber(L, ImageDB::getPositionY());
+	return 1;
+}
+
+int LuaFastBindings::CameraSetZoom(lua_State* L) {
+	ImageDB::setZoom(CheckFloat(L, 1));
+	return 0;
+}
+
+int LuaFastBindings::CameraGetZoom(lua_State* L) {
+	lua_pushnumber(L, ImageDB::getZoom());
+	return 1;
+}
+
+int LuaFastBindings::ApplicationGetFrame(lua_State* L) {
+	lua_pushinteger(L, Helper::GetFrameNumber());
+	return 1;
+}
+
+int LuaFastBindings::AudioPlay(lua_State* L) {
+	int channel = CheckInt(L, 1);
+	size_t length = 0;
+	const char* name = luaL_checklstring(L, 2, &length);
+	bool loop = lua_toboolean(L, 3);
+	Mix_Chunk* chunk = audio_cache.Get(name, length, 0, [](const std::string& audio_name, int) {
+		return AudioDB::GetAudio(audio_name);
+		});
+	AudioDB::PlayChunk(channel, chunk, loop);
+	return 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include "lua/lua.hpp"
+
+//Small direct-mapped cache from a Lua string to whatever the engine looks it up as. Short Lua
+//strings are interned, so the same name arrives with the same pointer every call and a hit costs
+//a pointer compare plus a memcmp to make sure the slot wasn't reused by a different string.
+template <typename T>
+class NameCache
+{
+private:
+	static const size_t SLOT_COUNT = 64;
+
+	struct Slot {
+		const char* key = nullptr;
+		int extra = 0;
+		std::string name;
+		T value{};
+	};
+
+	Slot slots[SLOT_COUNT];
+
+public:
+	//extra is folded into the key, for lookups like fonts that also need a size
+	template <typename Loader>
+	T Get(const char* name, size_t length, int extra, Loader load) {
+		size_t index = ((reinterpret_cast<uintptr_t>(name) >> 4) ^ static_cast<size_t>(extra)) & (SLOT_COUNT - 1);
+		Slot& slot = slots[index];
+		if (slot.key == name && slot.extra == extra && slot.name.size() == length
+			&& std::memcmp(slot.name.data(), name, length) == 0) {
+			return slot.value;
+		}
+		slot.key = name;
+		slot.extra = extra;
+		slot.name.assign(name, length);
+		slot.value = load(slot.name, extra);
+		return slot.value;
+	}
+};
+
+//Hand-written lua_CFunctions for the engine calls scripts make every frame. They read their
+//arguments straight off the Lua stack with no temporary std::strings, and resolve image, font,
+//sound and key names through NameCaches instead of hashing the name on every call.
+class LuaFastBindings
+{
+public:
+	//Image
+	static int ImageDraw(lua_State* L);
+	static int ImageDrawEx(lua_State* L);
+	static int ImageDrawUI(lua_State* L);
+	static int ImageDrawUIEx(lua_State* L);
+	static int ImageDrawPixel(lua_State* L);
+
+	//Text
+	static int TextDraw(lua_State* L);
+
+	//Input
+	static int InputGetKey(lua_State* L);
+	static int InputGetKeyDown(lua_State* L);
+	static int InputGetKeyUp(lua_State* L);
+	static int InputGetMouseButton(lua_State* L);
+	static int InputGetMouseButtonDown(lua_State* L);
+	static int InputGetMouseButtonUp(lua_State* L);
+	static int InputGetMouseScrollDelta(lua_State* L);
+
+	//Camera
+	static int CameraSetPosition(lua_State* L);
+	static int CameraGetPositionX(lua_State* L);
+	static int CameraGetPositionY(lua_State* L);
+	static int CameraSetZoom(lua_State* L);
+	static int CameraGetZoom(lua_State* L);
+
+	//Application and Audio
+	static int ApplicationGetFrame(lua_State* L);
+	static int AudioPlay(lua_State* L);
+};
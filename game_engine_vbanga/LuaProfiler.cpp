@@ -0,0 +1,120 @@
+#include "LuaProfiler.h"
+#include "Helper.h"
+#include <algorithm>
+#include <vector>
+#include <cstring>
+
+lua_State* LuaProfiler::lua_state = nullptr;
+bool LuaProfiler::enabled = false;
+int LuaProfiler::sample_interval = 1000;
+size_t LuaProfiler::total_samples = 0;
+std::unordered_map<std::string, size_t> LuaProfiler::folded_stacks;
+std::string LuaProfiler::stack_buffer;
+std::string LuaProfiler::frame_buffer;
+
+const char* const PROFILE_OUTPUT_FILENAME = "lua_profile.folded";
+const int MAX_SAMPLED_DEPTH = 64;
+
+void LuaProfiler::Init(lua_State* L) {
+	lua_state = L;
+	if (!Helper::IsLuaProfilerMode()) {
+		return;
+	}
+
+	//LUAPROFILER=1 is how the variable usually gets switched on, so only numbers above 1 are taken as an interval.
+	//Anything else (1, on, true) keeps the default rate rather than hooking every instruction.
+	std::string interval = Helper::GetEnvVariable("LUAPROFILER");
+	if (!interval.empty()) {
+		try {
+			int value = std::stoi(interval);
+			if (value > 1) {
+				sample_interval = value;
+			}
+		}
+		catch (const std::exception&) {
+		}
+	}
+
+	enabled = true;
+	stack_buffer.reserve(1024);
+	frame_buffer.reserve(256);
+	//Coroutines created later inherit the hook from the main thread
+	lua_sethook(lua_state, SampleHook, LUA_MASKCOUNT, sample_interval);
+}
+
+void LuaProfiler::SampleHook(lua_State* L, lua_Debug*) {
+	//Collect the stack leaf-first, then emit it root-first, which is the order folded stacks use
+	lua_Debug frames[MAX_SAMPLED_DEPTH];
+	int depth = 0;
+	while (depth < MAX_SAMPLED_DEPTH && lua_getstack(L, depth, &frames[depth])) {
+		depth++;
+	}
+	if (depth == 0) return;
+
+	stack_buffer.clear();
+	for (int level = depth - 1; level >= 0; level--) {
+		lua_Debug& frame = frames[level];
+		lua_getinfo(L, "Sn", &frame);
+
+		frame_buffer.clear();
+		if (frame.name) {
+			frame_buffer += frame.name;
+		}
+		else if (frame.what && std::strcmp(frame.what, "main") == 0) {
+			frame_buffer += "main chunk";
+		}
+		else {
+			frame_buffer += "?";
+		}
+		if (frame.what && std::strcmp(frame.what, "C") == 0) {
+			frame_buffer += " [C]";
+		}
+		else {
+			frame_buffer += " (";
+			frame_buffer += frame.short_src;
+			frame_buffer += ":";
+			frame_buffer += std::to_string(frame.linedefined);
+			frame_buffer += ")";
+		}
+		//';' separates frames, so it can't appear inside one. Spaces are fine: flamegraph tools only split
+		//the count off at the last space on the line
+		std::replace(frame_buffer.begin(), frame_buffer.end(), ';', ',');
+
+		if (!stack_buffer.empty()) stack_buffer += ';';
+		stack_buffer += frame_buffer;
+	}
+
+	folded_stacks[stack_buffer]++;
+	total_samples++;
+}
+
+void LuaProfiler::Shutdown() {
+	if (!enabled) return;
+	enabled = false;
+	if (lua_state) {
+		lua_sethook(lua_state, nullptr, 0, 0);
+	}
+
+	std::ofstream output(PROFILE_OUTPUT_FILENAME, std::ios::out | std::ios::trunc);
+	if (!output.is_open()) {
+		std::cerr << "Error : Failed to open " << PROFILE_OUTPUT_FILENAME << " for writing." << std::endl;
+		return;
+	}
+
+	//Heaviest stacks first so the file is readable without a flamegraph tool too
+	std::vector<std::pair<const std::string*, size_t>> sorted;
+	sorted.reserve(folded_stacks.size());
+	for (const auto& [stack, count] : folded_stacks) {
+		sorted.push_back({ &stack, count });
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+		return a.second > b.second;
+		});
+	for (const auto& [stack, count] : sorted) {
+		output << *stack << " " << count << "\n";
+	}
+	output.close();
+
+	std::cout << "Lua profiler: " << total_samples << " samples (every " << sample_interval
+		<< " instructions) written to " << PROFILE_OUTPUT_FILENAME << std::endl;
+}
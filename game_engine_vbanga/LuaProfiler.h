@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include "lua/lua.hpp"
+
+//Sampling profiler for Lua scripts. Every sample_interval Lua instructions the hook walks the
+//current Lua stack and counts it, and on exit the counts are written in folded-stack format
+//(one "root;caller;callee count" line per stack) so they can go straight into flamegraph tools.
+class LuaProfiler
+{
+private:
+	static lua_State* lua_state;
+	static bool enabled;
+	static int sample_interval;
+	static size_t total_samples;
+	static std::unordered_map<std::string, size_t> folded_stacks;
+	static std::string stack_buffer;
+	static std::string frame_buffer;
+
+	static void SampleHook(lua_State* L, lua_Debug* ar);
+public:
+	static void Init(lua_State* L);
+	static void Shutdown();
+	static bool IsEnabled() { return enabled; }
+	static size_t GetSampleCount() { return total_samples; }
+};
@@ -1,4 +1,12 @@
 #include "ParticleSystem.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+
+//Below this many particles the whole update runs inline; splitting it up would cost more than it saves
+const size_t PARTICLE_JOB_GRAIN = 2048;
+
+size_t ParticleSystem::live_particles = 0;
 
 void ParticleSystem::onStart()
 {
@@ -20,26 +28,21 @@ void ParticleSystem::onStart()
 
 void ParticleSystem::onUpdate()
 {
+	PROFILE_SCOPE("ParticleSystem");
+	ALLOC_SCOPE(TAG_PARTICLES);
 	if (local_frame_number % frames_between_bursts == 0 && emissions_enabled) {
 		for (size_t i = 0; i < burst_quantity; i++) {
 			createParticle();
 		}
 	}
-	for (size_t i = 0; i < starting_x_positions.size(); i++) {
-		if (lifespans[i] < duration_frames) {
-			//Update values!
-			float percent = (float) lifespans[i] / (float) duration_frames;
+	//Moving the particles is independent per particle, so big systems spread it over the job system.
+	//Drawing has to stay on this thread and in order, so it's a second pass.
+	JobSystem::ParallelFor(starting_x_positions.size(), PARTICLE_JOB_GRAIN, [this](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			if (lifespans[i] >= duration_frames) continue;
 			float& velocityX = starting_x_speeds[i];
 			float& velocityY = starting_y_speeds[i];
 			float& angularVel = starting_rotation_speeds[i];
-			float& posX = starting_x_positions[i];
-			float& posY = starting_y_positions[i];
-			float& rot = starting_rotations[i];
-			float scale = starting_scales[i];
-			float r = start_color_r;
-			float g = start_color_g;
-			float b = start_color_b;
-			float a = start_color_a;
 
 			velocityX += gravity_scale_x;
 			velocityY += gravity_scale_y;
@@ -48,6 +51,22 @@ void ParticleSystem::onUpdate()
 			velocityY *= drag_factor;
 			angularVel *= angular_drag_factor;
 
+			starting_x_positions[i] += velocityX;
+			starting_y_positions[i] += velocityY;
+			starting_rotations[i] += angularVel;
+		}
+	});
+
+	for (size_t i = 0; i < starting_x_positions.size(); i++) {
+		if (lifespans[i] < duration_frames) {
+			//Update values!
+			float percent = (float) lifespans[i] / (float) duration_frames;
+			float scale = starting_scales[i];
+			float r = start_color_r;
+			float g = start_color_g;
+			float b = start_color_b;
+			float a = start_color_a;
+
 			if (end_scale >= 0.0f) {
 				scale = glm::mix(starting_scales[i], end_scale, percent);
 			}
@@ -65,12 +84,8 @@ void ParticleSystem::onUpdate()
 				a = glm::mix(r, (float)end_color_a, percent);
 			}
 
-
-
-			posX += velocityX;
-			posY += velocityY;
-			rot += angularVel;
-			ImageDB::DrawEx(particleName, posX, posY, rot, scale, scale, 0.5f, 0.5f, r, g, b, a, sorting_order);
+			live_particles++;
+			ImageDB::DrawEx(particleName, starting_x_positions[i], starting_y_positions[i], starting_rotations[i], scale, scale, 0.5f, 0.5f, r, g, b, a, sorting_order);
 		}
 		else if (lifespans[i] == duration_frames) {
 			//Add it to the queue
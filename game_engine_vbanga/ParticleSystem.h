@@ -9,6 +9,7 @@
 
 class ParticleSystem
 {
+	friend class StateHash; //Hashes the particle arrays directly
 private:
 	//Limits
 	float emit_angle_min = 0.0f;
@@ -73,8 +74,11 @@ private:
 	std::vector<size_t> lifespans;
 	std::queue<size_t> openIndicies;
 
+	//Live particles drawn by every system since EngineStats last took the count
+	static size_t live_particles;
 
 public:
+	static size_t takeLiveParticleCount() { size_t count = live_particles; live_particles = 0; return count; }
 	//Getters and Setters
 	void setX(float val) { x = val; }
 	float getX() const { return x; }
@@ -0,0 +1,182 @@
+#include "Profiler.h"
+#include "Helper.h"
+#include <algorithm>
+
+bool Profiler::enabled = false;
+FILE* Profiler::trace_file = nullptr;
+bool Profiler::first_event = true;
+Uint64 Profiler::start_counter = 0;
+double Profiler::ticks_to_us = 0.0;
+std::mutex Profiler::rings_mutex;
+std::vector<Profiler::ThreadRing*> Profiler::rings;
+std::unordered_map<std::string, Profiler::Zone> Profiler::zones;
+std::unordered_map<const char*, Profiler::Zone*> Profiler::zone_lookup;
+size_t Profiler::dropped_events = 0;
+thread_local Profiler::ThreadRing* Profiler::thread_ring = nullptr;
+
+const char* const TRACE_OUTPUT_FILENAME = "frame_profile.json";
+
+void Profiler::Init() {
+	if (enabled || !Helper::IsFrameProfilerMode()) {
+		return;
+	}
+
+	trace_file = std::fopen(TRACE_OUTPUT_FILENAME, "w");
+	if (!trace_file) {
+		std::cerr << "Error : Failed to open " << TRACE_OUTPUT_FILENAME << " for writing." << std::endl;
+		return;
+	}
+	std::fputs("{\"traceEvents\":[\n", trace_file);
+	first_event = true;
+	start_counter = SDL_GetPerformanceCounter();
+	ticks_to_us = 1000000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+	enabled = true;
+	SetThreadName("main");
+}
+
+void Profiler::Shutdown() {
+	if (!enabled) return;
+	//Scopes still open on other threads see this and stop recording
+	enabled = false;
+	EndFrame();
+
+	{
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		for (ThreadRing* ring : rings) {
+			std::fprintf(trace_file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				first_event ? "" : ",\n", ring->thread_id, ring->thread_name.c_str());
+			first_event = false;
+		}
+	}
+	std::fputs("\n]}\n", trace_file);
+	std::fclose(trace_file);
+	trace_file = nullptr;
+
+	//Slowest zones first
+	std::vector<std::pair<std::string, ZoneStats>> summary;
+	for (const auto& [name, zone] : zones) {
+		summary.push_back({ name, GetZoneStats(name) });
+	}
+	std::sort(summary.begin(), summary.end(), [](const auto& a, const auto& b) {
+		return a.second.avg_ms > b.second.avg_ms;
+		});
+	std::cout << "Frame profiler: trace written to " << TRACE_OUTPUT_FILENAME;
+	if (dropped_events > 0) {
+		std::cout << " (" << dropped_events << " events dropped, ring buffers were full)";
+	}
+	std::cout << "\nzone ms per frame over the last " << STATS_WINDOW << " frames it ran in (min / avg / p99):" << std::endl;
+	for (const auto& [name, stats] : summary) {
+		std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(9) << stats.min_ms << std::setw(9) << stats.avg_ms << std::setw(9) << stats.p99_ms << std::endl;
+	}
+	std::cout.unsetf(std::ios::fixed);
+}
+
+void Profiler::SetThreadName(const char* thread_name) {
+	if (!enabled) return;
+	ThreadRing* ring = GetThreadRing();
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	ring->thread_name = thread_name;
+}
+
+Profiler::ThreadRing* Profiler::GetThreadRing() {
+	if (thread_ring) return thread_ring;
+
+	//Once per thread. Rings are never freed, since the engine's threads live as long as it does.
+	ThreadRing* ring = new ThreadRing();
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	ring->thread_id = static_cast<int>(rings.size()) + 1;
+	ring->thread_name = "thread " + std::to_string(ring->thread_id);
+	rings.push_back(ring);
+	thread_ring = ring;
+	return ring;
+}
+
+void Profiler::Record(const char* name, Uint64 begin, Uint64 end) {
+	ThreadRing* ring = GetThreadRing();
+	uint32_t head = ring->head.load(std::memory_order_relaxed);
+	ring->events[head % RING_CAPACITY] = { name, begin, end };
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::Drain(ThreadRing* ring) {
+	uint32_t head = ring->head.load(std::memory_order_acquire);
+	if (head - ring->tail > RING_CAPACITY) {
+		dropped_events += head - ring->tail - RING_CAPACITY;
+		ring->tail = head - RING_CAPACITY;
+	}
+
+	for (; ring->tail != head; ring->tail++) {
+		Event event = ring->events[ring->tail % RING_CAPACITY];
+		//If the writer has lapped this slot while it was being copied, the copy can't be trusted
+		if (ring->head.load(std::memory_order_acquire) - ring->tail > RING_CAPACITY) {
+			dropped_events++;
+			continue;
+		}
+
+		auto found = zone_lookup.find(event.name);
+		Zone* zone;
+		if (found == zone_lookup.end()) {
+			//The same name can come from different translation units with different pointers
+			zone = &zones[event.name];
+			zone->name = event.name;
+			zone_lookup[event.name] = zone;
+		}
+		else {
+			zone = found->second;
+		}
+		zone->frame_ticks += event.end - event.begin;
+		zone->hit = true;
+
+		std::fprintf(trace_file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+			first_event ? "" : ",\n", event.name, ring->thread_id,
+			static_cast<double>(event.begin - start_counter) * ticks_to_us,
+			static_cast<double>(event.end - event.begin) * ticks_to_us);
+		first_event = false;
+	}
+}
+
+void Profiler::EndFrame() {
+	if (!trace_file) return;
+
+	{
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		for (ThreadRing* ring : rings) {
+			Drain(ring);
+		}
+	}
+
+	//Per-zone totals go into the rolling window for the frames the zone ran in
+	double ticks_to_ms = ticks_to_us / 1000.0;
+	for (auto& [name, zone] : zones) {
+		if (!zone.hit) continue;
+		double ms = static_cast<double>(zone.frame_ticks) * ticks_to_ms;
+		if (zone.window.size() < STATS_WINDOW) {
+			zone.window.push_back(ms);
+		}
+		else {
+			zone.window[zone.window_next] = ms;
+		}
+		zone.window_next = (zone.window_next + 1) % STATS_WINDOW;
+		zone.frame_ticks = 0;
+		zone.hit = false;
+	}
+}
+
+Profiler::ZoneStats Profiler::GetZoneStats(const std::string& name) {
+	ZoneStats stats;
+	auto found = zones.find(name);
+	if (found == zones.end() || found->second.window.empty()) return stats;
+
+	std::vector<double> sorted = found->second.window;
+	std::sort(sorted.begin(), sorted.end());
+	double total = 0.0;
+	for (double ms : sorted) {
+		total += ms;
+	}
+	stats.frames = sorted.size();
+	stats.min_ms = sorted.front();
+	stats.avg_ms = total / static_cast<double>(sorted.size());
+	stats.p99_ms = sorted[std::min(sorted.size() - 1, (sorted.size() * 99) / 100)];
+	return stats;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "SDL.h"
+
+//Frame profiler, enabled by the FRAMEPROFILER environment variable. PROFILE_SCOPE("name") times
+//the rest of the enclosing block; scopes nest, and can be used from any thread.
+//Each thread records finished scopes into its own ring buffer, which only that thread writes,
+//and the main thread drains every ring once a frame (EndFrame), appending the events to a
+//Chrome trace (frame_profile.json, open it in chrome://tracing or ui.perfetto.dev) and folding
+//them into per-zone totals. The last STATS_WINDOW frames of each zone's total are kept for
+//min/avg/p99 figures, which are printed on exit.
+//When the variable isn't set a scope is a single branch on a static bool.
+//Zone names must be string literals (or otherwise outlive the run): only the pointer is recorded.
+class Profiler
+{
+public:
+	static constexpr size_t STATS_WINDOW = 300;
+
+	struct ZoneStats {
+		double min_ms = 0.0;
+		double avg_ms = 0.0;
+		double p99_ms = 0.0;
+		size_t frames = 0;
+	};
+
+	class Scope {
+		const char* name;
+		Uint64 begin;
+	public:
+		explicit Scope(const char* zone_name) : name(zone_name), begin(enabled ? SDL_GetPerformanceCounter() : 0) {}
+		~Scope() { if (begin != 0) Record(name, begin, SDL_GetPerformanceCounter()); }
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+private:
+	static constexpr uint32_t RING_CAPACITY = 1 << 14;
+
+	struct Event {
+		const char* name;
+		Uint64 begin;
+		Uint64 end;
+	};
+
+	//Single producer (the owning thread), single consumer (the main thread in EndFrame)
+	struct ThreadRing {
+		Event events[RING_CAPACITY];
+		std::atomic<uint32_t> head{ 0 };
+		uint32_t tail = 0;
+		int thread_id = 0;
+		std::string thread_name;
+	};
+
+	struct Zone {
+		std::string name;
+		Uint64 frame_ticks = 0;
+		bool hit = false;
+		std::vector<double> window;
+		size_t window_next = 0;
+	};
+
+	static bool enabled;
+	static FILE* trace_file;
+	static bool first_event;
+	static Uint64 start_counter;
+	static double ticks_to_us;
+	static std::mutex rings_mutex;
+	static std::vector<ThreadRing*> rings;
+	static std::unordered_map<std::string, Zone> zones;
+	static std::unordered_map<const char*, Zone*> zone_lookup;
+	static size_t dropped_events;
+	static thread_local ThreadRing* thread_ring;
+
+	static ThreadRing* GetThreadRing();
+	static void Record(const char* name, Uint64 begin, Uint64 end);
+	static void Drain(ThreadRing* ring);
+public:
+	static void Init();
+	static void Shutdown();
+	static bool IsEnabled() { return enabled; }
+	static void SetThreadName(const char* thread_name);
+	static void EndFrame();
+	static ZoneStats GetZoneStats(const std::string& name);
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
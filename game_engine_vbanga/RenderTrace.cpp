@@ -0,0 +1,126 @@
+#include "RenderTrace.h"
+#include <cstring>
+#include <iostream>
+
+FILE* RenderTrace::trace_file = nullptr;
+std::vector<char> RenderTrace::active_buffer;
+std::vector<std::vector<char>> RenderTrace::full_buffers;
+std::vector<std::vector<char>> RenderTrace::spare_buffers;
+std::unordered_map<int, std::string> RenderTrace::actor_names;
+std::thread RenderTrace::writer;
+std::mutex RenderTrace::buffer_mutex;
+std::condition_variable RenderTrace::buffer_ready;
+bool RenderTrace::stopping = false;
+
+//About 65k draws per buffer, so a busy scene hands the writer a buffer every few dozen frames
+const size_t TRACE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+bool RenderTrace::Init(const std::string& path) {
+	if (trace_file) return true;
+	trace_file = std::fopen(path.c_str(), "wb");
+	if (!trace_file) {
+		std::cerr << "Error : Failed to open " << path << " for writing." << std::endl;
+		return false;
+	}
+
+	active_buffer.reserve(TRACE_BUFFER_SIZE);
+	FileHeader header;
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	Append(&header, sizeof(header));
+
+	stopping = false;
+	writer = std::thread(&RenderTrace::WriterLoop);
+	return true;
+}
+
+void RenderTrace::Shutdown() {
+	if (!trace_file) return;
+	SubmitActiveBuffer();
+	{
+		std::lock_guard<std::mutex> lock(buffer_mutex);
+		stopping = true;
+	}
+	buffer_ready.notify_one();
+	if (writer.joinable()) writer.join();
+	std::fclose(trace_file);
+	trace_file = nullptr;
+}
+
+void RenderTrace::Draw(int frame, int actor_id, const std::string& actor_name, const void* texture, const float* dstrect, float angle, const float* center, int flip, float x_scale, float y_scale) {
+	if (!trace_file) return;
+
+	//Names are written once per actor id rather than with every draw
+	auto name = actor_names.find(actor_id);
+	if (name == actor_names.end() || name->second != actor_name) {
+		actor_names[actor_id] = actor_name;
+		NameRecord name_record{ TAG_NAME, actor_id, static_cast<uint32_t>(actor_name.size()) };
+		Append(&name_record, sizeof(name_record));
+		Append(actor_name.data(), actor_name.size());
+	}
+
+	DrawRecord record{};
+	record.tag = TAG_DRAW;
+	record.frame = frame;
+	record.actor_id = actor_id;
+	record.texture = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(texture));
+	if (dstrect) {
+		record.flags |= HAS_DSTRECT;
+		std::memcpy(record.dstrect, dstrect, sizeof(record.dstrect));
+	}
+	record.angle = angle;
+	if (center) {
+		record.flags |= HAS_CENTER;
+		std::memcpy(record.center, center, sizeof(record.center));
+	}
+	record.flip = flip;
+	record.scale[0] = x_scale;
+	record.scale[1] = y_scale;
+	Append(&record, sizeof(record));
+}
+
+void RenderTrace::Append(const void* data, size_t size) {
+	if (active_buffer.size() + size > TRACE_BUFFER_SIZE) {
+		SubmitActiveBuffer();
+	}
+	const char* bytes = static_cast<const char*>(data);
+	active_buffer.insert(active_buffer.end(), bytes, bytes + size);
+}
+
+void RenderTrace::SubmitActiveBuffer() {
+	if (active_buffer.empty()) return;
+	{
+		std::lock_guard<std::mutex> lock(buffer_mutex);
+		full_buffers.push_back(std::move(active_buffer));
+		if (!spare_buffers.empty()) {
+			active_buffer = std::move(spare_buffers.back());
+			spare_buffers.pop_back();
+		}
+		else {
+			active_buffer = std::vector<char>();
+		}
+	}
+	buffer_ready.notify_one();
+	active_buffer.clear();
+	active_buffer.reserve(TRACE_BUFFER_SIZE);
+}
+
+void RenderTrace::WriterLoop() {
+	std::vector<std::vector<char>> writing;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(buffer_mutex);
+			//Hand the written buffers back for reuse so the main thread isn't allocating 4MB at a time
+			for (std::vector<char>& buffer : writing) {
+				spare_buffers.push_back(std::move(buffer));
+			}
+			writing.clear();
+			buffer_ready.wait(lock, [] { return stopping || !full_buffers.empty(); });
+			if (full_buffers.empty()) return;
+			writing.swap(full_buffers);
+		}
+		for (const std::vector<char>& buffer : writing) {
+			std::fwrite(buffer.data(), 1, buffer.size(), trace_file);
+		}
+	}
+}
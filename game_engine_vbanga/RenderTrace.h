@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//Binary per-draw render trace, written when RENDERLOGGER is set. Draws are appended to a large
+//in-memory buffer as fixed-size records and full buffers are written to disk by a background
+//thread, so tracing costs a memcpy per draw instead of a formatted, flushed line.
+//tools/render_trace_to_text converts a trace back into the render_logger.txt format.
+//
+//File layout: FileHeader, then a stream of records that each begin with a uint32 tag.
+//  TAG_NAME: NameRecord followed by name_length bytes; sets the name used for that actor id from here on
+//  TAG_DRAW: DrawRecord
+class RenderTrace
+{
+public:
+	static constexpr char MAGIC[4] = { 'V', 'A', 'R', 'T' };
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint32_t TAG_NAME = 1;
+	static constexpr uint32_t TAG_DRAW = 2;
+	static constexpr uint32_t HAS_DSTRECT = 1;
+	static constexpr uint32_t HAS_CENTER = 2;
+
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+	};
+	struct NameRecord {
+		uint32_t tag;
+		int32_t actor_id;
+		uint32_t name_length;
+	};
+	struct DrawRecord {
+		uint32_t tag;
+		int32_t frame;
+		int32_t actor_id;
+		uint32_t flags;
+		uint64_t texture;
+		float dstrect[4];
+		float angle;
+		float center[2];
+		int32_t flip;
+		float scale[2];
+	};
+private:
+	static FILE* trace_file;
+	static std::vector<char> active_buffer;
+	static std::vector<std::vector<char>> full_buffers;
+	static std::vector<std::vector<char>> spare_buffers;
+	static std::unordered_map<int, std::string> actor_names;
+	static std::thread writer;
+	static std::mutex buffer_mutex;
+	static std::condition_variable buffer_ready;
+	static bool stopping;
+
+	static void Append(const void* data, size_t size);
+	static void SubmitActiveBuffer();
+	static void WriterLoop();
+public:
+	static bool Init(const std::string& path);
+	static void Shutdown();
+	static bool IsEnabled() { return trace_file != nullptr; }
+	static void Draw(int frame, int actor_id, const std::string& actor_name, const void* texture, const float* dstrect, float angle, const float* center, int flip, float x_scale, float y_scale);
+};
@@ -3,6 +3,10 @@
 #include "ActorDB.h"
 
 b2World* RigidBody::world = nullptr;
+float RigidBody::step_seconds = 1.0f / 60.0f;
+int RigidBody::velocity_iterations = 8;
+int RigidBody::position_iterations = 3;
+float RigidBody::interpolation_alpha = 0.0f;
 CollisionDetector* RigidBody::contactListener;
 
 
@@ -179,7 +183,13 @@ RigidBody::RigidBody() {
 
 void RigidBody::step() {
 	if (!world) return;
-	world->Step(1.0f / 60.0f, 8, 3);
+	for (b2Body* current = world->GetBodyList(); current; current = current->GetNext()) {
+		RigidBody* owner = reinterpret_cast<RigidBody*>(current->GetUserData().pointer);
+		if (!owner) continue;
+		owner->previous_position = current->GetPosition();
+		owner->previous_angle = current->GetAngle();
+	}
+	world->Step(step_seconds, velocity_iterations, position_iterations);
 }
 
 void RigidBody::onStart() {
@@ -199,6 +209,9 @@ void RigidBody::onStart() {
 	tempBody.angularDamping = angular_friction;
 	tempBody.angle = rotation * (b2_pi / 180.0f);
 	body = world->CreateBody(&tempBody);
+	body->GetUserData().pointer = reinterpret_cast<uintptr_t>(this);
+	previous_position = tempBody.position;
+	previous_angle = tempBody.angle;
 	//Create temp shape
 	if (!has_collider && !has_trigger) {
 		b2PolygonShape phantom_shape;
@@ -17,8 +17,13 @@ public:
 };
 
 class RigidBody {
+	friend class StateHash; //Hashes the body's transform and velocities directly
 private:
 	static b2World* world;
+	static float step_seconds;
+	static int velocity_iterations;
+	static int position_iterations;
+	static float interpolation_alpha;
 	float x = 0.0f;
 	float y = 0.0f;
 	float width = 1.0f;
@@ -43,12 +48,19 @@ private:
 	float trigger_radius = 0.5f;
 	std::string trigger_type = "box";
 
-	b2Body* body;
+	b2Body* body = nullptr;
 	ActorDB* actor = nullptr;
+	//Transform before the most recent physics step, for interpolating between ticks when drawing
+	b2Vec2 previous_position = b2Vec2(0.0f, 0.0f);
+	float previous_angle = 0.0f;
 	static CollisionDetector* contactListener;
 public:
 	RigidBody();
 	static void step();
+	static void configure(float step, int velocity_iters, int position_iters) { step_seconds = step; velocity_iterations = velocity_iters; position_iterations = position_iters; }
+	static void setInterpolationAlpha(float val) { interpolation_alpha = val; }
+	static int getBodyCount() { return world ? world->GetBodyCount() : 0; }
+	static int getContactCount() { return world ? world->GetContactCount() : 0; }
 	void setActor(ActorDB* val) { actor = val; }
 	void setX(float val) { x = val; }
 	void setY(float val) { y = val; }
@@ -82,8 +94,8 @@ public:
 	float GetRotation() { if (!body) { return rotation; } return (body->GetAngle() * (180.0f / b2_pi)); }
 	void AddForce(b2Vec2 value) { body->ApplyForceToCenter(value, true); }
 	void SetVelocity(b2Vec2 value) { body->SetLinearVelocity(value); }
-	void SetPosition(b2Vec2 value) { if (!body) { x = value.x; y = value.y; return; } body->SetTransform(value, rotation); }
-	void SetRotation(float value) { if (!body) { rotation = value; return; }body->SetTransform(GetPosition(), value * (b2_pi / 180.0f)); }
+	void SetPosition(b2Vec2 value) { if (!body) { x = value.x; y = value.y; return; } body->SetTransform(value, rotation); previous_position = value; }
+	void SetRotation(float value) { if (!body) { rotation = value; return; }body->SetTransform(GetPosition(), value * (b2_pi / 180.0f)); previous_angle = body->GetAngle(); }
 	void SetAngularVelocity(float value) { body->SetAngularVelocity(value * (b2_pi / 180.0f)); }
 	void SetGravityScale(float value) {
 		if (!body) { gravity_scale = value; return; } body->SetGravityScale(value);
@@ -118,6 +130,32 @@ public:
 		return result;
 	}
 
+	//Allocation-free accessors for scripts. The XY versions return multiple values straight onto
+	//the Lua stack, and the Into versions overwrite a Vector2 the script already owns.
+	int GetPositionXY(lua_State* L) { b2Vec2 value = GetPosition(); lua_pushnumber(L, value.x); lua_pushnumber(L, value.y); return 2; }
+	int GetVelocityXY(lua_State* L) { b2Vec2 value = body ? body->GetLinearVelocity() : b2Vec2(0.0f, 0.0f); lua_pushnumber(L, value.x); lua_pushnumber(L, value.y); return 2; }
+	int GetUpDirectionXY(lua_State* L) { b2Vec2 value = GetUpDirection(); lua_pushnumber(L, value.x); lua_pushnumber(L, value.y); return 2; }
+	int GetRightDirectionXY(lua_State* L) { b2Vec2 value = GetRightDirection(); lua_pushnumber(L, value.x); lua_pushnumber(L, value.y); return 2; }
+	void GetPositionInto(b2Vec2* out) { if (out) { *out = GetPosition(); } }
+	void GetVelocityInto(b2Vec2* out) { if (out) { *out = body ? body->GetLinearVelocity() : b2Vec2(0.0f, 0.0f); } }
+	void GetUpDirectionInto(b2Vec2* out) { if (out) { *out = GetUpDirection(); } }
+	void GetRightDirectionInto(b2Vec2* out) { if (out) { *out = GetRightDirection(); } }
+	//Where the body should be drawn this frame: between the last two physics states, by how far
+	//the fixed timestep has got towards the next tick. Gameplay code should keep using GetPosition.
+	b2Vec2 GetRenderPosition() {
+		if (!body) { return b2Vec2(x, y); }
+		b2Vec2 current = body->GetPosition();
+		return previous_position + interpolation_alpha * (current - previous_position);
+	}
+	float GetRenderRotation() {
+		if (!body) { return rotation; }
+		return (previous_angle + interpolation_alpha * (body->GetAngle() - previous_angle)) * (180.0f / b2_pi);
+	}
+	int GetRenderPositionXY(lua_State* L) { b2Vec2 value = GetRenderPosition(); lua_pushnumber(L, value.x); lua_pushnumber(L, value.y); return 2; }
+	void SetPositionXY(float value_x, float value_y) { SetPosition(b2Vec2(value_x, value_y)); }
+	void SetVelocityXY(float value_x, float value_y) { SetVelocity(b2Vec2(value_x, value_y)); }
+	void AddForceXY(float value_x, float value_y) { AddForce(b2Vec2(value_x, value_y)); }
+
 	void OnDestroy();
 	static luabridge::LuaRef Raycast(b2Vec2 pos, b2Vec2 dir, float dist);
 	static luabridge::LuaRef RaycastAll(b2Vec2 pos, b2Vec2 dir, float dist);
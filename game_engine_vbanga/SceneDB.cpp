@@ -16,6 +16,16 @@
 #include "Input.h"
 #include "box2d/box2d.h"
 #include "ParticleSystem.h"
+#include "ScriptWorkers.h"
+#include "CoroutineScheduler.h"
+#include "Timers.h"
+#include "LuaFastBindings.h"
+#include "InputActions.h"
+#include "FixedTimestep.h"
+#include "FramePacer.h"
+#include "FramePipeline.h"
+#include "EngineStats.h"
+#include "AllocTracker.h"
 
 /*
 Gameplan: Change update to only iterate through characters that move
@@ -95,24 +105,32 @@ void SceneDB::loadComponents() {
 		.beginNamespace("Application")
 		.addFunction("Quit", &SceneDB::quit)
 		.addFunction("Sleep", &SceneDB::sleep)
-		.addFunction("GetFrame", Helper::GetFrameNumber)
+		.addCFunction("GetFrame", &LuaFastBindings::ApplicationGetFrame)
 		.addFunction("OpenURL", &SceneDB::openURL)
+		.addCFunction("StartCoroutine", &CoroutineScheduler::StartCoroutine)
+		.addCFunction("StopCoroutine", &CoroutineScheduler::StopCoroutine)
+		.addCFunction("WaitFrames", &CoroutineScheduler::WaitFrames)
+		.addCFunction("WaitSeconds", &CoroutineScheduler::WaitSeconds)
+		.addCFunction("WaitForEvent", &CoroutineScheduler::WaitForEvent)
+		.addCFunction("SetTimeout", &Timers::SetTimeout)
+		.addCFunction("SetInterval", &Timers::SetInterval)
+		.addCFunction("ClearTimer", &Timers::ClearTimer)
+		.addCFunction("GetDeltaTime", &FramePacer::LuaGetDeltaTime)
+		.addCFunction("GetTime", &FramePacer::LuaGetTime)
+		.addCFunction("GetFixedDeltaTime", &FixedTimestep::GetFixedDeltaTime)
+		.addCFunction("GetStats", &EngineStats::LuaGetStats)
 		.endNamespace();
-	luabridge::getGlobalNamespace(lua_state)
-		.beginClass<glm::vec2>("vec2")
-		.addProperty("x", &glm::vec2::x)
-		.addProperty("y", &glm::vec2::y)
-		.endClass();
+	//The calls scripts make every frame are raw lua_CFunctions, see LuaFastBindings.h
 	luabridge::getGlobalNamespace(lua_state)
 		.beginNamespace("Input")
-		.addFunction("GetKey", &Input::GetKey)
-		.addFunction("GetKeyDown", &Input::GetKeyDown)
-		.addFunction("GetKeyUp", &Input::GetKeyUp)
+		.addCFunction("GetKey", &LuaFastBindings::InputGetKey)
+		.addCFunction("GetKeyDown", &LuaFastBindings::InputGetKeyDown)
+		.addCFunction("GetKeyUp", &LuaFastBindings::InputGetKeyUp)
 		.addFunction("GetMousePosition", &Input::GetMousePosition)
-		.addFunction("GetMouseButton", &Input::GetMouseButton)
-		.addFunction("GetMouseButtonDown", &Input::GetMouseDown)
-		.addFunction("GetMouseButtonUp", &Input::GetMouseUp)
-		.addFunction("GetMouseScrollDelta", &Input::GetMouseScrollDelta)
+		.addCFunction("GetMouseButton", &LuaFastBindings::InputGetMouseButton)
+		.addCFunction("GetMouseButtonDown", &LuaFastBindings::InputGetMouseButtonDown)
+		.addCFunction("GetMouseButtonUp", &LuaFastBindings::InputGetMouseButtonUp)
+		.addCFunction("GetMouseScrollDelta", &LuaFastBindings::InputGetMouseScrollDelta)
 		.addFunction("HideCursor", &Input::HideCursor)
 		.addFunction("ShowCursor", &Input::ShowCursor)
 		.addFunction("GetControllerButton", &Input::GetControllerButton)
@@ -122,32 +140,40 @@ void SceneDB::loadComponents() {
 		.addFunction("GetControllerRightStick", &Input::GetControllerRightStick)
 		.addFunction("GetControllerLeftTrigger", &Input::GetControllerLeftTrigger)
 		.addFunction("GetControllerRightTrigger", &Input::GetControllerRightTrigger)
+		.addCFunction("GetAction", &InputActions::GetAction)
+		.addCFunction("GetActionDown", &InputActions::GetActionDown)
+		.addCFunction("GetActionUp", &InputActions::GetActionUp)
+		.addCFunction("GetAxis", &InputActions::GetAxis)
+		.addCFunction("RebindAction", &InputActions::RebindAction)
+		.addCFunction("RebindAxis", &InputActions::RebindAxis)
 		.endNamespace();
+	Input::RegisterKeyTable(lua_state);
+	InputActions::RegisterTables(lua_state);
 	luabridge::getGlobalNamespace(lua_state)
 		.beginNamespace("Text")
-		.addFunction("Draw", &TextDB::DrawText)
+		.addCFunction("Draw", &LuaFastBindings::TextDraw)
 		.endNamespace();
 	luabridge::getGlobalNamespace(lua_state)
 		.beginNamespace("Audio")
-		.addFunction("Play", &AudioDB::PlayAudio)
+		.addCFunction("Play", &LuaFastBindings::AudioPlay)
 		.addFunction("Halt", &AudioDB::Halt)
 		.addFunction("SetVolume", &AudioDB::SetVolume)
 		.endNamespace();
 	luabridge::getGlobalNamespace(lua_state)
 		.beginNamespace("Image")
-		.addFunction("Draw", &ImageDB::Draw)
-		.addFunction("DrawEx", &ImageDB::DrawEx)
-		.addFunction("DrawUI", &ImageDB::DrawUI)
-		.addFunction("DrawUIEx", &ImageDB::DrawUIEx)
-		.addFunction("DrawPixel", &ImageDB::DrawPixel)
+		.addCFunction("Draw", &LuaFastBindings::ImageDraw)
+		.addCFunction("DrawEx", &LuaFastBindings::ImageDrawEx)
+		.addCFunction("DrawUI", &LuaFastBindings::ImageDrawUI)
+		.addCFunction("DrawUIEx", &LuaFastBindings::ImageDrawUIEx)
+		.addCFunction("DrawPixel", &LuaFastBindings::ImageDrawPixel)
 		.endNamespace();
 	luabridge::getGlobalNamespace(lua_state)
 		.beginNamespace("Camera")
-		.addFunction("SetPosition", &ImageDB::setCamera)
-		.addFunction("GetPositionX", &ImageDB::getPositionX)
-		.addFunction("GetPositionY", &ImageDB::getPositionY)
-		.addFunction("SetZoom", &ImageDB::setZoom)
-		.addFunction("GetZoom", &ImageDB::getZoom)
+		.addCFunction("SetPosition", &LuaFastBindings::CameraSetPosition)
+		.addCFunction("GetPositionX", &LuaFastBindings::CameraGetPositionX)
+		.addCFunction("GetPositionY", &LuaFastBindings::CameraGetPositionY)
+		.addCFunction("SetZoom", &LuaFastBindings::CameraSetZoom)
+		.addCFunction("GetZoom", &LuaFastBindings::CameraGetZoom)
 		.endNamespace();
 	luabridge::getGlobalNamespace(lua_state)
 		.beginNamespace("Scene")
@@ -155,22 +181,7 @@ void SceneDB::loadComponents() {
 		.addFunction("GetCurrent", &SceneDB::getCurrent)
 		.addFunction("DontDestroy", &SceneDB::DontDestroy)
 		.endNamespace();
-	luabridge::getGlobalNamespace(lua_state)
-		.beginClass<b2Vec2>("Vector2")
-		.addConstructor<void(*) (float, float)>()
-		.addProperty("x", &b2Vec2::x)
-		.addProperty("y", &b2Vec2::y)
-		.addFunction("Normalize", &b2Vec2::Normalize)
-		.addFunction("Length", &b2Vec2::Length)
-		.addFunction("__add", &b2Vec2::operator_add)
-		.addFunction("__sub", &b2Vec2::operator_sub)
-		.addFunction("__mul", &b2Vec2::operator_mul)
-		.endClass();
-	luabridge::getGlobalNamespace(lua_state)
-		.beginNamespace("Vector2")
-		.addFunction("Distance", &b2Distance)
-		.addFunction("Dot", static_cast<float (*)(const b2Vec2&, const b2Vec2&)>(&b2Dot))
-		.endNamespace();
+	loadMathBindings(lua_state);
 	luabridge::getGlobalNamespace(lua_state)
 		.beginClass<RigidBody>("Rigidbody")
 		.addFunction("OnStart", &RigidBody::onStart)
@@ -191,6 +202,20 @@ void SceneDB::loadComponents() {
 		.addFunction("GetGravityScale", &RigidBody::GetGravityScale)
 		.addFunction("GetUpDirection", &RigidBody::GetUpDirection)
 		.addFunction("GetRightDirection", &RigidBody::GetRightDirection)
+		.addFunction("GetPositionXY", &RigidBody::GetPositionXY)
+		.addFunction("GetVelocityXY", &RigidBody::GetVelocityXY)
+		.addFunction("GetUpDirectionXY", &RigidBody::GetUpDirectionXY)
+		.addFunction("GetRightDirectionXY", &RigidBody::GetRightDirectionXY)
+		.addFunction("GetPositionInto", &RigidBody::GetPositionInto)
+		.addFunction("GetVelocityInto", &RigidBody::GetVelocityInto)
+		.addFunction("GetUpDirectionInto", &RigidBody::GetUpDirectionInto)
+		.addFunction("GetRightDirectionInto", &RigidBody::GetRightDirectionInto)
+		.addFunction("GetRenderPosition", &RigidBody::GetRenderPosition)
+		.addFunction("GetRenderRotation", &RigidBody::GetRenderRotation)
+		.addFunction("GetRenderPositionXY", &RigidBody::GetRenderPositionXY)
+		.addFunction("SetPositionXY", &RigidBody::SetPositionXY)
+		.addFunction("SetVelocityXY", &RigidBody::SetVelocityXY)
+		.addFunction("AddForceXY", &RigidBody::AddForceXY)
 		.addProperty("x", &RigidBody::getX, &RigidBody::setX)
 		.addProperty("y", &RigidBody::getY, &RigidBody::setY)
 		.addProperty("rotation", &RigidBody::getRotation, &RigidBody::setRotation)
@@ -267,7 +292,42 @@ void SceneDB::loadComponents() {
 		}
 	}
 
+void SceneDB::loadMathBindings(lua_State* L) {
+	//Pure value types, shared with the script worker states
+	luabridge::getGlobalNamespace(L)
+		.beginClass<glm::vec2>("vec2")
+		.addProperty("x", &glm::vec2::x)
+		.addProperty("y", &glm::vec2::y)
+		.endClass();
+	luabridge::getGlobalNamespace(L)
+		.beginClass<b2Vec2>("Vector2")
+		.addConstructor<void(*) (float, float)>()
+		.addProperty("x", &b2Vec2::x)
+		.addProperty("y", &b2Vec2::y)
+		.addFunction("Normalize", &b2Vec2::Normalize)
+		.addFunction("Length", &b2Vec2::Length)
+		.addFunction("__add", &b2Vec2::operator_add)
+		.addFunction("__sub", &b2Vec2::operator_sub)
+		.addFunction("__mul", &b2Vec2::operator_mul)
+		.addFunction("Set", &b2Vec2::Set)
+		.addFunction("CopyFrom", &b2Vec2::CopyFrom)
+		.addFunction("AddInPlace", &b2Vec2::AddInPlace)
+		.addFunction("SubInPlace", &b2Vec2::SubInPlace)
+		.addFunction("MulInPlace", &b2Vec2::MulInPlace)
+		.endClass();
+	luabridge::getGlobalNamespace(L)
+		.beginNamespace("Vector2")
+		.addFunction("Distance", &b2Distance)
+		.addFunction("Dot", static_cast<float (*)(const b2Vec2&, const b2Vec2&)>(&b2Dot))
+		.endNamespace();
+}
+
 void SceneDB::quit() {
+	//The simulation thread can't exit() under the render thread, so the pipeline stops after this frame
+	if (FramePipeline::IsRunning()) {
+		FramePipeline::RequestQuit();
+		return;
+	}
 	exit(0);
 }
 void SceneDB::sleep(int milliseconds) {
@@ -548,6 +608,10 @@ void SceneDB::loadValues(const rapidjson::Value& values, ActorDB* tempActor, boo
 					}
 				}
 				tempActor->addComponent(componentName, componentInstance);
+				if (ScriptWorkers::IsParallelType(value)) {
+					tempActor->setParallel(componentName);
+					ScriptWorkers::Register(tempActor, componentName, value, componentInstance);
+				}
 			}
 			else {
 				//Now I just override values, and that's it.
@@ -611,6 +675,8 @@ void SceneDB::loadScene(std::string sceneName, const bool& initial = false) {
 		std::cout << "error: scene " << sceneName << " is missing";
 		exit(0);
 	}
+	ALLOC_SCOPE(TAG_SCENE);
+	AllocTracker::ResetWarmup();
 	this->sceneName = sceneName;
 	if (!initial) {
 		for (auto& [key, actor] : sceneActors) {
@@ -660,23 +726,45 @@ void SceneDB::loadScene(std::string sceneName, const bool& initial = false) {
 void SceneDB::start() {
 	nextScene = sceneName;
 	for (auto& [key, actor] : sceneActors) {
+		CoroutineScheduler::SetOwner(actor);
 		actor->start();
 	}
+	CoroutineScheduler::SetOwner(nullptr);
 }
 
 void SceneDB::update() {
 	//Well, as it turns out, none of it matters in homework 7. Go me!
+	//Parallel components run on the script workers while the main thread handles everything else
+	ScriptWorkers::BeginUpdate();
 	for (auto& [key, actor] : sceneActors) {
+		CoroutineScheduler::SetOwner(actor);
 		actor->update();
 	}
+	CoroutineScheduler::SetOwner(nullptr);
+	ScriptWorkers::FinishUpdate();
+	//Only coroutines whose wait is over get resumed
+	CoroutineScheduler::Tick();
 
 
 }
 
+void SceneDB::fixedUpdate() {
+	//Runs once per physics tick, right before the world is stepped
+	for (auto& [key, actor] : sceneActors) {
+		CoroutineScheduler::SetOwner(actor);
+		actor->fixedUpdate();
+	}
+	CoroutineScheduler::SetOwner(nullptr);
+}
+
 void SceneDB::lateUpdate() {
+	ScriptWorkers::BeginLateUpdate();
 	for (auto& [key, actor] : sceneActors) {
+		CoroutineScheduler::SetOwner(actor);
 		actor->lateUpdate();
 	}
+	CoroutineScheduler::SetOwner(nullptr);
+	ScriptWorkers::FinishLateUpdate();
 	for (auto& [type, comp, func] : toSubscribe) {
 		SceneDB::eventSubscriptions[type].emplace_back(comp, func);
 	}
@@ -794,6 +882,22 @@ void SceneDB::Destroy(luabridge::LuaRef reference) {
 	currentInstance->actors_to_remove.push_back(key);
 }
 
+void SceneDB::DestroyByKey(int key) {
+	//Used by the script workers, which only know actors by ID
+	ActorDB* actor = nullptr;
+	auto it = currentInstance->sceneActors.find(key);
+	if (it != currentInstance->sceneActors.end()) {
+		actor = it->second;
+	}
+	for (ActorDB* added : currentInstance->actors_to_add) {
+		if (added->getKey() == key) actor = added;
+	}
+	if (!actor || actor->getDelete()) return;
+	actor->setDelete(true);
+	actor->disableAll();
+	currentInstance->actors_to_remove.push_back(key);
+}
+
 void SceneDB::alterActors() {
 	//Add all values that need to be added
 	for (ActorDB* actor : actors_to_add) {
@@ -818,12 +922,23 @@ void SceneDB::checkForChange() {
 	loadScene(nextScene, false);
 }
 
+size_t SceneDB::getComponentCount() const {
+	size_t count = 0;
+	for (const auto& [key, actor] : sceneActors) {
+		count += actor->getComponentsMap().size();
+	}
+	return count;
+}
+
 
 std::unordered_map<std::string, std::vector<std::pair<luabridge::LuaRef, luabridge::LuaRef>>> SceneDB::eventSubscriptions;
 std::vector<std::tuple<std::string, luabridge::LuaRef, luabridge::LuaRef>> SceneDB::toSubscribe;
 std::vector<std::tuple<std::string, luabridge::LuaRef, luabridge::LuaRef>> SceneDB::toUnsubscribe;
 
 void SceneDB::EventPublish(std::string type, luabridge::LuaRef eventObject) {
+	if (CoroutineScheduler::HasEventWaiters()) {
+		CoroutineScheduler::OnEvent(type, eventObject);
+	}
 	for (auto& [component, func] : eventSubscriptions[type]) {
 		if (component.isTable() && func.isFunction()) {
 			try {
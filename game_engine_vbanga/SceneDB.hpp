@@ -75,21 +75,27 @@ public:
 	void loadValues(const rapidjson::Value& values, ActorDB* tempActor, bool);
 	void EstablishInheritance(luabridge::LuaRef& instance_table, luabridge::LuaRef& parent_table);
 	void loadComponents();
+	static void loadMathBindings(lua_State*);
 	static void log(std::string);
 	void loadTemplate(const std::string&, ActorDB*);
 	static void setLuaState(lua_State*);
 	static luabridge::LuaRef Find(std::string name);
 	static luabridge::LuaRef FindAll(std::string name);
 	void lateUpdate();
+	void fixedUpdate();
 	void start();
 	static void quit();
 	static void sleep(int);
 	static void openURL(std::string);
 	static luabridge::LuaRef Instantiate(std::string templateName);
 	static void Destroy(luabridge::LuaRef);
+	static void DestroyByKey(int key);
 	void alterActors();
 	static void DontDestroy(luabridge::LuaRef);
 	void checkForChange();
+	size_t getActorCount() const { return sceneActors.size(); }
+	const std::unordered_map<int, ActorDB*>& getActors() const { return sceneActors; }
+	size_t getComponentCount() const;
 	static void Load(std::string value) { currentInstance->nextScene = value; }
 	static std::string getCurrent() { return currentInstance->sceneName; }
 	static void EventPublish(std::string type, luabridge::LuaRef eventObject);
@@ -0,0 +1,437 @@
+#include "ScriptWorkers.h"
+#include "SceneDB.hpp"
+#include "ActorDB.h"
+#include "Helper.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+#include <filesystem>
+#include <iostream>
+
+lua_State* ScriptWorkers::main_state = nullptr;
+std::vector<ScriptWorkers::Worker*> ScriptWorkers::workers;
+std::unordered_set<std::string> ScriptWorkers::parallel_types;
+std::vector<ScriptWorkers::PendingChange> ScriptWorkers::pending;
+size_t ScriptWorkers::next_worker = 0;
+
+JobSystem::JobCounter ScriptWorkers::batch;
+bool ScriptWorkers::running = false;
+bool ScriptWorkers::has_late_update = false;
+
+void ScriptWorkers::Init(lua_State* L, int worker_count) {
+	main_state = L;
+	if (worker_count <= 0) return;
+
+	//A component type opts in by setting parallel = true in its table
+	const std::string componentDir = "resources/component_types";
+	if (!std::filesystem::exists(componentDir)) return;
+	std::vector<std::filesystem::path> parallel_files;
+	for (const auto& entry : std::filesystem::directory_iterator(componentDir)) {
+		if (entry.path().extension() != ".lua") continue;
+		std::string typeName = entry.path().stem().string();
+		luabridge::LuaRef componentTemplate = luabridge::getGlobal(main_state, typeName.c_str());
+		if (!componentTemplate.isTable() || !componentTemplate["parallel"].isBool() || !componentTemplate["parallel"]) continue;
+		parallel_types.insert(typeName);
+		parallel_files.push_back(entry.path());
+		if (componentTemplate["OnLateUpdate"].isFunction()) {
+			has_late_update = true;
+		}
+	}
+	if (parallel_types.empty()) return;
+
+	worker_count = std::min(worker_count, 64);
+	for (int i = 0; i < worker_count; i++) {
+		Worker* worker = new Worker();
+		lua_State* W = luaL_newstate();
+		AllocTracker::TrackLuaState(W);
+		luaL_openlibs(W);
+		worker->lua_state = W;
+		*static_cast<Worker**>(lua_getextraspace(W)) = worker;
+
+		//Only calls that don't touch shared engine state are exposed to worker scripts
+		SceneDB::loadMathBindings(W);
+		luabridge::getGlobalNamespace(W)
+			.beginNamespace("Debug")
+			.addFunction("Log", &ScriptWorkers::WorkerLog)
+			.endNamespace();
+		luabridge::getGlobalNamespace(W)
+			.beginNamespace("Application")
+			.addFunction("GetFrame", Helper::GetFrameNumber)
+			.endNamespace();
+		luabridge::getGlobalNamespace(W)
+			.beginNamespace("Event")
+			.addFunction("Publish", &ScriptWorkers::WorkerPublish)
+			.endNamespace();
+		luabridge::getGlobalNamespace(W)
+			.beginNamespace("Actor")
+			.addFunction("Destroy", &ScriptWorkers::WorkerDestroy)
+			.endNamespace();
+
+		for (const std::filesystem::path& path : parallel_files) {
+			if (luaL_dofile(W, path.string().c_str()) != LUA_OK) {
+				std::cout << "problem with lua file " << path.stem().string();
+				exit(0);
+			}
+		}
+		workers.push_back(worker);
+	}
+
+}
+
+void ScriptWorkers::Shutdown() {
+	JobSystem::Wait(&batch);
+	running = false;
+}
+
+ScriptWorkers::Worker* ScriptWorkers::GetWorker(lua_State* L) {
+	return *static_cast<Worker**>(lua_getextraspace(L));
+}
+
+void ScriptWorkers::Register(ActorDB* owner, const std::string& key, const std::string& type, luabridge::LuaRef main_instance) {
+	//Applied once the workers are idle, which also lets scene/template overrides land on the main table first
+	pending.push_back({ true, owner, key, type, main_instance });
+}
+
+void ScriptWorkers::Unregister(ActorDB* owner, const std::string& key) {
+	pending.push_back({ false, owner, key, "", luabridge::LuaRef(main_state) });
+}
+
+void ScriptWorkers::ApplyPending() {
+	if (pending.empty()) return;
+	//A component added and removed before the workers saw it never reaches them, and its
+	//owner may already be deleted, so cancel the pair instead of dereferencing it
+	for (size_t i = 0; i < pending.size(); i++) {
+		if (pending[i].add) continue;
+		for (size_t j = 0; j < i; j++) {
+			PendingChange& earlier = pending[j];
+			if (earlier.add && !earlier.cancelled && earlier.owner == pending[i].owner && earlier.key == pending[i].key) {
+				earlier.cancelled = true;
+				pending[i].cancelled = true;
+				break;
+			}
+		}
+	}
+	for (PendingChange& change : pending) {
+		if (change.cancelled) continue;
+		if (change.add) {
+			AddComponent(change);
+		}
+		else {
+			RemoveComponent(change);
+		}
+	}
+	pending.clear();
+}
+
+void ScriptWorkers::AddComponent(PendingChange& change) {
+	//Round-robin keeps the shards balanced and the assignment deterministic
+	Worker* worker = workers[next_worker++ % workers.size()];
+	lua_State* W = worker->lua_state;
+
+	lua_newtable(W);
+	int instance = lua_gettop(W);
+
+	auto metatable = worker->metatables.find(change.type);
+	if (metatable == worker->metatables.end()) {
+		lua_newtable(W);
+		lua_getglobal(W, change.type.c_str());
+		lua_setfield(W, -2, "__index");
+		metatable = worker->metatables.insert({ change.type, luaL_ref(W, LUA_REGISTRYINDEX) }).first;
+	}
+	lua_rawgeti(W, LUA_REGISTRYINDEX, metatable->second);
+	lua_setmetatable(W, instance);
+
+	change.main_instance.push(main_state);
+	CopyFields(main_state, lua_gettop(main_state), W, instance);
+	lua_pop(main_state, 1);
+
+	int actor_id = change.owner->getKey();
+	std::string actor_name = change.owner->getName();
+	lua_pushinteger(W, actor_id);
+	lua_setfield(W, instance, "actor_id");
+	lua_pushstring(W, actor_name.c_str());
+	lua_setfield(W, instance, "actor_name");
+
+	ParallelComponent component{ change.owner, actor_id, actor_name, change.key, change.main_instance };
+	component.worker_ref = luaL_ref(W, LUA_REGISTRYINDEX);
+	std::vector<FieldValue> fields;
+	change.main_instance.push(main_state);
+	ReadFields(main_state, -1, fields);
+	lua_pop(main_state, 1);
+	for (FieldValue& field : fields) {
+		component.mirrored[field.key] = field;
+	}
+	worker->components.push_back(component);
+}
+
+void ScriptWorkers::RemoveComponent(const PendingChange& change) {
+	for (Worker* worker : workers) {
+		auto it = std::find_if(worker->components.begin(), worker->components.end(), [&](const ParallelComponent& component) {
+			return component.owner == change.owner && component.key == change.key;
+			});
+		if (it == worker->components.end()) continue;
+
+		CallHook(worker, *it, "OnDestroy");
+		luaL_unref(worker->lua_state, LUA_REGISTRYINDEX, it->worker_ref);
+		worker->components.erase(it);
+		return;
+	}
+}
+
+void ScriptWorkers::CopyFields(lua_State* from, int from_index, lua_State* to, int to_index) {
+	from_index = lua_absindex(from, from_index);
+	to_index = lua_absindex(to, to_index);
+	lua_pushnil(from);
+	while (lua_next(from, from_index) != 0) {
+		//Only plain data crosses states; functions, tables and userdata stay where they were created
+		if (lua_type(from, -2) == LUA_TSTRING) {
+			size_t key_length = 0;
+			const char* key = lua_tolstring(from, -2, &key_length);
+			int value_type = lua_type(from, -1);
+			if (value_type == LUA_TNUMBER || value_type == LUA_TSTRING || value_type == LUA_TBOOLEAN) {
+				lua_pushlstring(to, key, key_length);
+				if (value_type == LUA_TNUMBER) {
+					if (lua_isinteger(from, -1)) lua_pushinteger(to, lua_tointeger(from, -1));
+					else lua_pushnumber(to, lua_tonumber(from, -1));
+				}
+				else if (value_type == LUA_TSTRING) {
+					size_t length = 0;
+					const char* text = lua_tolstring(from, -1, &length);
+					lua_pushlstring(to, text, length);
+				}
+				else {
+					lua_pushboolean(to, lua_toboolean(from, -1));
+				}
+				lua_rawset(to, to_index);
+			}
+		}
+		lua_pop(from, 1);
+	}
+}
+
+void ScriptWorkers::ReadFields(lua_State* L, int index, std::vector<FieldValue>& out) {
+	if (!lua_istable(L, index)) return;
+	index = lua_absindex(L, index);
+	lua_pushnil(L);
+	while (lua_next(L, index) != 0) {
+		int value_type = lua_type(L, -1);
+		if (lua_type(L, -2) == LUA_TSTRING && (value_type == LUA_TNUMBER || value_type == LUA_TSTRING || value_type == LUA_TBOOLEAN)) {
+			FieldValue field;
+			field.key = lua_tostring(L, -2);
+			field.lua_type = value_type;
+			if (value_type == LUA_TNUMBER) {
+				field.is_integer = lua_isinteger(L, -1);
+				field.integer = lua_tointeger(L, -1);
+				field.number = lua_tonumber(L, -1);
+			}
+			else if (value_type == LUA_TSTRING) field.text = lua_tostring(L, -1);
+			else field.boolean = lua_toboolean(L, -1);
+			out.push_back(field);
+		}
+		lua_pop(L, 1);
+	}
+}
+
+bool ScriptWorkers::SameValue(const FieldValue& a, const FieldValue& b) {
+	if (a.lua_type != b.lua_type) return false;
+	if (a.lua_type == LUA_TNUMBER) return a.is_integer == b.is_integer && (a.is_integer ? a.integer == b.integer : a.number == b.number);
+	if (a.lua_type == LUA_TSTRING) return a.text == b.text;
+	return a.boolean == b.boolean;
+}
+
+void ScriptWorkers::PushValue(lua_State* L, const FieldValue& field) {
+	if (field.lua_type == LUA_TNUMBER) {
+		if (field.is_integer) lua_pushinteger(L, field.integer);
+		else lua_pushnumber(L, field.number);
+	}
+	else if (field.lua_type == LUA_TSTRING) {
+		lua_pushlstring(L, field.text.data(), field.text.size());
+	}
+	else {
+		lua_pushboolean(L, field.boolean);
+	}
+}
+
+void ScriptWorkers::SyncFields(Worker* worker, ParallelComponent& component, bool take_worker_fields) {
+	lua_State* W = worker->lua_state;
+	lua_rawgeti(W, LUA_REGISTRYINDEX, component.worker_ref);
+	component.main_instance.push(main_state);
+
+	//Anything on the main-state table that differs from what was last mirrored there was written by a
+	//main-thread script, so it goes to the worker (and is then mirrored back unchanged below)
+	std::vector<FieldValue> fields;
+	ReadFields(main_state, -1, fields);
+	for (FieldValue& field : fields) {
+		auto mirrored = component.mirrored.find(field.key);
+		if (mirrored != component.mirrored.end() && SameValue(mirrored->second, field)) continue;
+		lua_pushlstring(W, field.key.data(), field.key.size());
+		PushValue(W, field);
+		lua_rawset(W, -3);
+		component.mirrored[field.key] = field;
+	}
+
+	if (take_worker_fields) {
+		CopyFields(W, -1, main_state, -1);
+		fields.clear();
+		ReadFields(W, -1, fields);
+		for (FieldValue& field : fields) {
+			component.mirrored[field.key] = field;
+		}
+	}
+	lua_pop(main_state, 1);
+	lua_pop(W, 1);
+}
+
+bool ScriptWorkers::CallHook(Worker* worker, ParallelComponent& component, const char* hook) {
+	lua_State* W = worker->lua_state;
+	lua_rawgeti(W, LUA_REGISTRYINDEX, component.worker_ref);
+	lua_getfield(W, -1, hook);
+	if (!lua_isfunction(W, -1)) {
+		lua_pop(W, 2);
+		return false;
+	}
+	lua_pushvalue(W, -2);
+	if (lua_pcall(W, 1, 0, 0) != LUA_OK) {
+		const char* message = lua_tostring(W, -1);
+		worker->errors.push_back(component.actor_name + " : " + (message ? message : "unknown error"));
+		lua_pop(W, 1);
+	}
+	lua_pop(W, 1);
+	return true;
+}
+
+void ScriptWorkers::RunPhase(Worker* worker, Phase phase) {
+	PROFILE_SCOPE("ScriptWorkers::RunPhase");
+	for (ParallelComponent& component : worker->components) {
+		if (!component.enabled) continue;
+		if (phase == PHASE_UPDATE) {
+			if (!component.started) {
+				component.started = true;
+				CallHook(worker, component, "OnStart");
+			}
+			CallHook(worker, component, "OnUpdate");
+		}
+		else {
+			CallHook(worker, component, "OnLateUpdate");
+		}
+	}
+}
+
+void ScriptWorkers::StartBatch(Phase phase) {
+	ApplyPending();
+
+	//Actor.Destroy and RemoveComponent disable components through the main-state table, so that
+	//copy of "enabled" wins over the worker's until the batch has run
+	for (Worker* worker : workers) {
+		lua_State* W = worker->lua_state;
+		for (ParallelComponent& component : worker->components) {
+			SyncFields(worker, component, false);
+			component.main_instance.push(main_state);
+			lua_pushliteral(main_state, "enabled");
+			lua_rawget(main_state, -2);
+			component.enabled = !(lua_isboolean(main_state, -1) && !lua_toboolean(main_state, -1));
+			lua_pop(main_state, 2);
+
+			lua_rawgeti(W, LUA_REGISTRYINDEX, component.worker_ref);
+			lua_pushboolean(W, component.enabled);
+			lua_setfield(W, -2, "enabled");
+			lua_pop(W, 1);
+		}
+	}
+
+	running = true;
+	for (Worker* worker : workers) {
+		JobSystem::Submit([worker, phase]() { RunPhase(worker, phase); }, &batch);
+	}
+}
+
+void ScriptWorkers::FinishBatch() {
+	if (!running) return;
+	PROFILE_SCOPE("ScriptWorkers::FinishBatch");
+	//Whichever jobs haven't been picked up yet run here rather than leaving this thread idle
+	JobSystem::Wait(&batch);
+	running = false;
+
+	//Workers are idle again, so the main thread may touch their states now
+	for (Worker* worker : workers) {
+		for (ParallelComponent& component : worker->components) {
+			SyncFields(worker, component, true);
+		}
+
+		for (std::string& error : worker->errors) {
+			std::replace(error.begin(), error.end(), '\\', '/');
+			std::cout << "\033[31m" << error << "\033[0m" << std::endl;
+		}
+		worker->errors.clear();
+
+		//Commands are applied in worker order so the outcome doesn't depend on thread timing
+		for (Command& command : worker->commands) {
+			if (command.type == Command::LOG) {
+				SceneDB::log(command.text);
+			}
+			else if (command.type == Command::PUBLISH) {
+				luabridge::LuaRef eventObject = luabridge::newTable(main_state);
+				//Pushed as they were read, so integers arrive as integers just as they would from a main-state publish
+				eventObject.push(main_state);
+				for (FieldValue& field : command.fields) {
+					PushValue(main_state, field);
+					lua_setfield(main_state, -2, field.key.c_str());
+				}
+				lua_pop(main_state, 1);
+				SceneDB::EventPublish(command.text, eventObject);
+			}
+			else if (command.type == Command::DESTROY) {
+				SceneDB::DestroyByKey(command.actor_id);
+			}
+		}
+		worker->commands.clear();
+	}
+}
+
+void ScriptWorkers::BeginUpdate() {
+	if (workers.empty()) return;
+	StartBatch(PHASE_UPDATE);
+}
+
+void ScriptWorkers::FinishUpdate() {
+	if (workers.empty()) return;
+	FinishBatch();
+}
+
+void ScriptWorkers::BeginLateUpdate() {
+	if (workers.empty() || !has_late_update) return;
+	StartBatch(PHASE_LATE_UPDATE);
+}
+
+void ScriptWorkers::FinishLateUpdate() {
+	if (workers.empty()) return;
+	FinishBatch();
+}
+
+int ScriptWorkers::WorkerLog(lua_State* L) {
+	size_t length = 0;
+	const char* text = luaL_tolstring(L, 1, &length);
+	Command command;
+	command.type = Command::LOG;
+	command.text = std::string(text, length);
+	GetWorker(L)->commands.push_back(command);
+	lua_pop(L, 1);
+	return 0;
+}
+
+int ScriptWorkers::WorkerPublish(lua_State* L) {
+	Command command;
+	command.type = Command::PUBLISH;
+	command.text = luaL_checkstring(L, 1);
+	//Event objects are flattened to their plain fields on the way to the main state
+	ReadFields(L, 2, command.fields);
+	GetWorker(L)->commands.push_back(command);
+	return 0;
+}
+
+int ScriptWorkers::WorkerDestroy(lua_State* L) {
+	Command command;
+	command.type = Command::DESTROY;
+	command.actor_id = static_cast<int>(luaL_checkinteger(L, 1));
+	GetWorker(L)->commands.push_back(command);
+	return 0;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "JobSystem.h"
+#include "lua/lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+
+class ActorDB;
+
+//Runs component types flagged "parallel = true" on a pool of worker lua_States.
+//Each worker owns its own Lua state and a shard of the parallel components, and each batch runs
+//their OnStart/OnUpdate/OnLateUpdate as one JobSystem job per worker while the main thread runs
+//everything else. Workers never touch the main state: they talk back through a command queue
+//(Debug.Log, Event.Publish, Actor.Destroy) that the main thread drains once the batch is done, and
+//after every batch the scalar fields of each worker instance are mirrored into its main-state table
+//so other scripts can still read them. Scalar fields other scripts write on the main-state table
+//are sent the other way before the next batch (and at the end of the batch they were written
+//during), and win over whatever the worker wrote to the same field in between. Tables, functions
+//and userdata are never mirrored either way.
+class ScriptWorkers
+{
+private:
+	enum Phase { PHASE_UPDATE, PHASE_LATE_UPDATE };
+
+	struct FieldValue {
+		std::string key;
+		int lua_type = LUA_TNIL;
+		bool is_integer = false;
+		lua_Integer integer = 0;
+		lua_Number number = 0;
+		std::string text;
+		bool boolean = false;
+	};
+
+	struct Command {
+		enum Type { LOG, PUBLISH, DESTROY } type = LOG;
+		std::string text;
+		int actor_id = -1;
+		std::vector<FieldValue> fields;
+	};
+
+	struct ParallelComponent {
+		const ActorDB* owner;
+		int actor_id;
+		std::string actor_name;
+		std::string key;
+		luabridge::LuaRef main_instance; //Only ever touched from the main thread
+		int worker_ref = LUA_NOREF;
+		bool started = false;
+		bool enabled = true;
+		//The plain fields as they were last mirrored between the two states, to spot what the main thread changed since
+		std::unordered_map<std::string, FieldValue> mirrored = {};
+	};
+
+	struct Worker {
+		lua_State* lua_state = nullptr;
+		std::vector<ParallelComponent> components;
+		std::unordered_map<std::string, int> metatables;
+		std::vector<Command> commands;
+		std::vector<std::string> errors;
+	};
+
+	struct PendingChange {
+		bool add;
+		ActorDB* owner;
+		std::string key;
+		std::string type;
+		luabridge::LuaRef main_instance;
+		bool cancelled = false;
+	};
+
+	static lua_State* main_state;
+	static std::vector<Worker*> workers;
+	static std::unordered_set<std::string> parallel_types;
+	static std::vector<PendingChange> pending;
+	static size_t next_worker;
+
+	static JobSystem::JobCounter batch;
+	static bool running;
+	static bool has_late_update;
+
+	static void RunPhase(Worker* worker, Phase phase);
+	static bool CallHook(Worker* worker, ParallelComponent& component, const char* hook);
+	static void StartBatch(Phase phase);
+	static void FinishBatch();
+	static void ApplyPending();
+	static void AddComponent(PendingChange& change);
+	static void RemoveComponent(const PendingChange& change);
+	static void CopyFields(lua_State* from, int from_index, lua_State* to, int to_index);
+	static void ReadFields(lua_State* L, int index, std::vector<FieldValue>& out);
+	static bool SameValue(const FieldValue& a, const FieldValue& b);
+	static void PushValue(lua_State* L, const FieldValue& field);
+	static void SyncFields(Worker* worker, ParallelComponent& component, bool take_worker_fields);
+	static Worker* GetWorker(lua_State* L);
+
+	//Engine API available inside worker states
+	static int WorkerLog(lua_State* L);
+	static int WorkerPublish(lua_State* L);
+	static int WorkerDestroy(lua_State* L);
+public:
+	static void Init(lua_State* L, int worker_count);
+	static void Shutdown();
+	static bool IsEnabled() { return !workers.empty(); }
+	static bool IsParallelType(const std::string& type) { return parallel_types.count(type) != 0; }
+	static void Register(ActorDB* owner, const std::string& key, const std::string& type, luabridge::LuaRef main_instance);
+	static void Unregister(ActorDB* owner, const std::string& key);
+	static void BeginUpdate();
+	static void FinishUpdate();
+	static void BeginLateUpdate();
+	static void FinishLateUpdate();
+};
@@ -0,0 +1,302 @@
+#include "StateHash.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "Helper.h"
+#include "Profiler.h"
+#include "SceneDB.hpp"
+
+const char* STATE_HASH_FILENAME = "state_hash.bin";
+
+FILE* StateHash::hash_file = nullptr;
+SceneDB* StateHash::scene = nullptr;
+lua_State* StateHash::lua_state = nullptr;
+std::vector<int> StateHash::actor_keys;
+std::vector<std::vector<StateHash::TableKey>> StateHash::keys_by_depth;
+std::unordered_set<const void*> StateHash::visited_tables;
+
+//Written ahead of each value so that, say, the string "1" and the integer 1 hash differently
+enum ValueTag : uint8_t {
+	VALUE_NIL,
+	VALUE_FALSE,
+	VALUE_TRUE,
+	VALUE_INTEGER,
+	VALUE_FLOAT,
+	VALUE_STRING,
+	VALUE_TABLE,
+	VALUE_TABLE_SEEN,
+	VALUE_TABLE_TOO_DEEP,
+	VALUE_FUNCTION,
+	VALUE_VECTOR2,
+	VALUE_ACTOR,
+	VALUE_RIGIDBODY,
+	VALUE_PARTICLE_SYSTEM,
+	VALUE_USERDATA,
+	VALUE_OTHER
+};
+
+void StateHash::Init(SceneDB* scene_manager, lua_State* L) {
+	if (hash_file || !Helper::IsStateHashMode()) {
+		return;
+	}
+
+	hash_file = std::fopen(STATE_HASH_FILENAME, "wb");
+	if (!hash_file) {
+		std::cerr << "Error : Failed to open " << STATE_HASH_FILENAME << " for writing." << std::endl;
+		return;
+	}
+	scene = scene_manager;
+	lua_state = L;
+	keys_by_depth.resize(MAX_TABLE_DEPTH + 1);
+
+	FileHeader header;
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.subsystem_count = SUBSYSTEM_COUNT;
+	std::fwrite(&header, sizeof(header), 1, hash_file);
+}
+
+void StateHash::Shutdown() {
+	if (!hash_file) return;
+	std::fclose(hash_file);
+	hash_file = nullptr;
+}
+
+void StateHash::Mix(uint64_t& hash, const void* data, size_t size) {
+	//FNV-1a; the point is telling two runs apart, not resisting anyone
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+}
+
+void StateHash::EndFrame(int frame) {
+	if (!hash_file) return;
+	PROFILE_SCOPE("StateHash");
+
+	FrameRecord record{};
+	record.frame = frame;
+	for (uint64_t& hash : record.hashes) {
+		hash = 14695981039346656037ull;
+	}
+	uint64_t& actors_hash = record.hashes[SUBSYSTEM_ACTORS];
+	uint64_t& bodies_hash = record.hashes[SUBSYSTEM_BODIES];
+	uint64_t& particles_hash = record.hashes[SUBSYSTEM_PARTICLES];
+	uint64_t& lua_hash = record.hashes[SUBSYSTEM_LUA];
+
+	const std::unordered_map<int, ActorDB*>& actors = scene->getActors();
+	record.actors = static_cast<uint32_t>(actors.size());
+	actor_keys.clear();
+	for (const auto& [key, actor] : actors) {
+		actor_keys.push_back(key);
+	}
+	std::sort(actor_keys.begin(), actor_keys.end());
+
+	for (int key : actor_keys) {
+		ActorDB* actor = actors.at(key);
+		const std::string name = actor->getName();
+		Mix(actors_hash, key);
+		Mix(actors_hash, name.size());
+		Mix(actors_hash, name.data(), name.size());
+		Mix(actors_hash, actor->getComponentsMap().size());
+
+		for (auto& [component_key, component] : actor->getComponentsMap()) {
+			Mix(actors_hash, component_key.size());
+			Mix(actors_hash, component_key.data(), component_key.size());
+
+			component.push(lua_state);
+			if (lua_istable(lua_state, -1)) {
+				Mix(lua_hash, key);
+				Mix(lua_hash, component_key.data(), component_key.size());
+				//Each component is walked on its own, so one that references another still hashes that one's fields
+				visited_tables.clear();
+				HashLuaValue(lua_hash, lua_gettop(lua_state), 0);
+			}
+			else if (luabridge::isInstance<RigidBody>(lua_state, -1)) {
+				const RigidBody* rigidbody = luabridge::Stack<RigidBody*>::get(lua_state, -1);
+				Mix(bodies_hash, key);
+				Mix(bodies_hash, component_key.data(), component_key.size());
+				if (rigidbody->body) {
+					//Straight from box2d, so nothing is rounded away by the degree conversions scripts see
+					b2Transform transform = rigidbody->body->GetTransform();
+					Mix(bodies_hash, transform.p.x);
+					Mix(bodies_hash, transform.p.y);
+					Mix(bodies_hash, rigidbody->body->GetAngle());
+					Mix(bodies_hash, rigidbody->body->GetLinearVelocity().x);
+					Mix(bodies_hash, rigidbody->body->GetLinearVelocity().y);
+					Mix(bodies_hash, rigidbody->body->GetAngularVelocity());
+				}
+				else {
+					Mix(bodies_hash, rigidbody->x);
+					Mix(bodies_hash, rigidbody->y);
+					Mix(bodies_hash, rigidbody->rotation);
+				}
+			}
+			else if (luabridge::isInstance<ParticleSystem>(lua_state, -1)) {
+				const ParticleSystem* particles = luabridge::Stack<ParticleSystem*>::get(lua_state, -1);
+				Mix(particles_hash, key);
+				Mix(particles_hash, component_key.data(), component_key.size());
+				Mix(particles_hash, particles->x);
+				Mix(particles_hash, particles->y);
+				Mix(particles_hash, particles->local_frame_number);
+				Mix(particles_hash, particles->emissions_enabled);
+				for (size_t i = 0; i < particles->lifespans.size(); i++) {
+					//Dead slots keep their old values until they're reused, so only live particles count
+					if (particles->lifespans[i] >= static_cast<size_t>(particles->duration_frames)) continue;
+					Mix(particles_hash, i);
+					Mix(particles_hash, particles->lifespans[i]);
+					Mix(particles_hash, particles->starting_x_positions[i]);
+					Mix(particles_hash, particles->starting_y_positions[i]);
+					Mix(particles_hash, particles->starting_rotations[i]);
+					Mix(particles_hash, particles->starting_scales[i]);
+					Mix(particles_hash, particles->starting_x_speeds[i]);
+					Mix(particles_hash, particles->starting_y_speeds[i]);
+					Mix(particles_hash, particles->starting_rotation_speeds[i]);
+				}
+			}
+			lua_pop(lua_state, 1);
+		}
+	}
+
+	std::fwrite(&record, sizeof(record), 1, hash_file);
+}
+
+void StateHash::HashLuaValue(uint64_t& hash, int index, int depth) {
+	lua_State* L = lua_state;
+	switch (lua_type(L, index)) {
+	case LUA_TNIL:
+		Mix(hash, VALUE_NIL);
+		break;
+	case LUA_TBOOLEAN:
+		Mix(hash, lua_toboolean(L, index) ? VALUE_TRUE : VALUE_FALSE);
+		break;
+	case LUA_TNUMBER:
+		if (lua_isinteger(L, index)) {
+			Mix(hash, VALUE_INTEGER);
+			Mix(hash, lua_tointeger(L, index));
+		}
+		else {
+			Mix(hash, VALUE_FLOAT);
+			Mix(hash, lua_tonumber(L, index));
+		}
+		break;
+	case LUA_TSTRING: {
+		size_t length = 0;
+		const char* string = lua_tolstring(L, index, &length);
+		Mix(hash, VALUE_STRING);
+		Mix(hash, length);
+		Mix(hash, string, length);
+		break;
+	}
+	case LUA_TTABLE:
+		if (depth >= MAX_TABLE_DEPTH) {
+			Mix(hash, VALUE_TABLE_TOO_DEEP);
+		}
+		else if (!visited_tables.insert(lua_topointer(L, index)).second) {
+			//Cycles and shared tables are only followed the first time the walk reaches them
+			Mix(hash, VALUE_TABLE_SEEN);
+		}
+		else {
+			Mix(hash, VALUE_TABLE);
+			HashLuaTable(hash, index, depth);
+		}
+		break;
+	case LUA_TFUNCTION:
+		//Closures are recreated every run, so there's nothing stable to hash but that one is there
+		Mix(hash, VALUE_FUNCTION);
+		break;
+	case LUA_TUSERDATA:
+		if (luabridge::isInstance<b2Vec2>(L, index)) {
+			const b2Vec2* vector = luabridge::Stack<b2Vec2*>::get(L, index);
+			Mix(hash, VALUE_VECTOR2);
+			Mix(hash, vector->x);
+			Mix(hash, vector->y);
+		}
+		else if (luabridge::isInstance<ActorDB>(L, index)) {
+			Mix(hash, VALUE_ACTOR);
+			Mix(hash, luabridge::Stack<ActorDB*>::get(L, index)->getKey());
+		}
+		//These have subsystems of their own
+		else if (luabridge::isInstance<RigidBody>(L, index)) {
+			Mix(hash, VALUE_RIGIDBODY);
+		}
+		else if (luabridge::isInstance<ParticleSystem>(L, index)) {
+			Mix(hash, VALUE_PARTICLE_SYSTEM);
+		}
+		else {
+			Mix(hash, VALUE_USERDATA);
+		}
+		break;
+	default:
+		Mix(hash, VALUE_OTHER);
+		break;
+	}
+}
+
+void StateHash::HashLuaTable(uint64_t& hash, int index, int depth) {
+	lua_State* L = lua_state;
+	index = lua_absindex(L, index);
+	lua_checkstack(L, 4);
+
+	//Only the table's own fields: the __index chain is the component type, which is the same code for every instance
+	std::vector<TableKey>& keys = keys_by_depth[depth];
+	keys.clear();
+	size_t unordered_keys = 0;
+	lua_pushnil(L);
+	while (lua_next(L, index) != 0) {
+		TableKey key{};
+		key.type = lua_type(L, -2);
+		if (key.type == LUA_TBOOLEAN) {
+			key.integer = lua_toboolean(L, -2);
+			keys.push_back(key);
+		}
+		else if (key.type == LUA_TNUMBER) {
+			key.is_integer = lua_isinteger(L, -2);
+			key.integer = lua_tointeger(L, -2);
+			key.number = lua_tonumber(L, -2);
+			keys.push_back(key);
+		}
+		else if (key.type == LUA_TSTRING) {
+			//The table keeps the key alive, so the pointer stays good for the rest of the walk
+			key.string = lua_tolstring(L, -2, &key.length);
+			keys.push_back(key);
+		}
+		else {
+			//Tables, functions and userdata as keys have no order that survives a rerun; just count them
+			unordered_keys++;
+		}
+		lua_pop(L, 1);
+	}
+
+	std::sort(keys.begin(), keys.end(), [](const TableKey& a, const TableKey& b) {
+		if (a.type != b.type) return a.type < b.type;
+		if (a.type == LUA_TSTRING) {
+			int order = std::memcmp(a.string, b.string, std::min(a.length, b.length));
+			return order != 0 ? order < 0 : a.length < b.length;
+		}
+		if (a.type == LUA_TBOOLEAN) return a.integer < b.integer;
+		if (a.is_integer != b.is_integer) return a.is_integer;
+		return a.is_integer ? a.integer < b.integer : a.number < b.number;
+	});
+
+	Mix(hash, keys.size());
+	Mix(hash, unordered_keys);
+	for (const TableKey& key : keys) {
+		if (key.type == LUA_TBOOLEAN) {
+			lua_pushboolean(L, static_cast<int>(key.integer));
+		}
+		else if (key.type == LUA_TNUMBER && key.is_integer) {
+			lua_pushinteger(L, key.integer);
+		}
+		else if (key.type == LUA_TNUMBER) {
+			lua_pushnumber(L, key.number);
+		}
+		else {
+			lua_pushlstring(L, key.string, key.length);
+		}
+		HashLuaValue(hash, -1, depth);
+		lua_rawget(L, index);
+		HashLuaValue(hash, lua_gettop(L), depth + 1);
+		lua_pop(L, 1);
+	}
+}
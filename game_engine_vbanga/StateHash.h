@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <unordered_set>
+#include <vector>
+#include "lua/lua.hpp"
+
+class SceneDB;
+
+//Per-frame hashes of the simulation state, written when STATEHASH is set, to check that a change
+//(threading, SIMD, the fixed timestep) leaves the simulation exactly where it was. Screenshots only
+//show what was drawn; these catch divergence in anything the game could read back. After every
+//simulated frame the world is hashed once per subsystem:
+//  actors     which actors exist, their names and the keys of their components
+//  bodies     every Rigidbody's position, angle and linear/angular velocity, bit for bit
+//  particles  every ParticleSystem's emitter state and live particles
+//  lua        a canonical walk of every component table: own fields in sorted key order, nested
+//             tables down to MAX_TABLE_DEPTH, Vector2s and actors by value, functions by type only
+//Actors are visited in key order and components in key order, so nothing depends on hash table
+//layout or addresses. Logs from two runs on the same input (two builds, or a build and a replay of
+//its recording) are compared with tools/state_hash_diff, which reports the first divergent frame
+//and which subsystems diverged on it.
+//
+//File layout: FileHeader, then one FrameRecord per simulated frame.
+class StateHash
+{
+public:
+	static constexpr char MAGIC[4] = { 'V', 'A', 'S', 'H' };
+	static constexpr uint32_t VERSION = 1;
+	static constexpr int MAX_TABLE_DEPTH = 8;
+
+	enum Subsystem {
+		SUBSYSTEM_ACTORS,
+		SUBSYSTEM_BODIES,
+		SUBSYSTEM_PARTICLES,
+		SUBSYSTEM_LUA,
+		SUBSYSTEM_COUNT
+	};
+	static constexpr const char* SUBSYSTEM_NAMES[SUBSYSTEM_COUNT] = { "actors", "bodies", "particles", "lua" };
+
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t subsystem_count;
+	};
+	struct FrameRecord {
+		int32_t frame;
+		uint32_t actors;
+		uint64_t hashes[SUBSYSTEM_COUNT];
+	};
+private:
+	//A table key that has a canonical order (booleans, numbers and strings)
+	struct TableKey {
+		int type;
+		bool is_integer;
+		lua_Integer integer;
+		lua_Number number;
+		const char* string;
+		size_t length;
+	};
+
+	static FILE* hash_file;
+	static SceneDB* scene;
+	static lua_State* lua_state;
+	static std::vector<int> actor_keys;
+	//One list per depth, so a nested walk doesn't clobber the keys of the table it's inside
+	static std::vector<std::vector<TableKey>> keys_by_depth;
+	static std::unordered_set<const void*> visited_tables;
+
+	static void Mix(uint64_t& hash, const void* data, size_t size);
+	template<class T>
+	static void Mix(uint64_t& hash, const T& value) { Mix(hash, &value, sizeof(value)); }
+	static void HashLuaValue(uint64_t& hash, int index, int depth);
+	static void HashLuaTable(uint64_t& hash, int index, int depth);
+public:
+	static void Init(SceneDB* scene_manager, lua_State* L);
+	static void Shutdown();
+	static bool IsEnabled() { return hash_file != nullptr; }
+	//Hashes the world as this frame left it; call once per simulated frame, on the thread simulating it
+	static void EndFrame(int frame);
+};
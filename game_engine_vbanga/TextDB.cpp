@@ -1,10 +1,19 @@
 #include "TextDB.h"
 #include "Helper.h"
+#include "Profiler.h"
+#include "HitchDetector.h"
+#include "AllocTracker.h"
 
 //TTF_Font* TextDB::currentFont;
 std::unordered_map<std::string, std::unordered_map<int, TTF_Font*>> TextDB::fonts;
 SDL_Renderer* TextDB::renderer = nullptr;
-std::queue<TextDB::TextType> TextDB::displayText;
+std::vector<TextDB::TextType> TextDB::displayText[3];
+int TextDB::write_list = 0;
+int TextDB::ready_list = 1;
+int TextDB::render_list = 2;
+bool TextDB::headless = false;
+size_t TextDB::draw_count = 0;
+std::atomic<int> TextDB::last_text_textures(0);
 
 void TextDB::LoadFont(const std::string& font_name, const int& font_size) {
     std::string font_path = "resources/fonts/" + font_name + ".ttf";
@@ -13,46 +22,76 @@ void TextDB::LoadFont(const std::string& font_name, const int& font_size) {
         exit(0);
     }
     
+    //Nothing is drawn headless, so the font never needs to be opened
+    if (headless) {
+        fonts[font_name][font_size] = nullptr;
+        return;
+    }
+    ALLOC_SCOPE(TAG_TEXT);
+    HitchDetector::CountAssetLoad();
     fonts[font_name][font_size] = TTF_OpenFont(font_path.c_str(), font_size);
 }
 
+TTF_Font* TextDB::GetFont(const std::string& font_name, int font_size) {
+    if (fonts.count(font_name) != 0 && fonts[font_name].count(font_size) != 0) {
+        //Already loaded, we chillin
+    }
+    else {
+        LoadFont(font_name, font_size);
+    }
+    return fonts[font_name][font_size];
+}
+
 void TextDB::DrawText(std::string str_content, float x, float y, std::string font_name, int font_size, int r, int g, int b, int a) {
     if (str_content == "") {
         return;
     }
 
+    DrawTextWithFont(str_content.c_str(), x, y, GetFont(font_name, font_size), r, g, b, a);
+}
 
-    if (fonts.count(font_name) != 0 && fonts[font_name].count(font_size) != 0) {
-        //Already loaded, we chillin
+void TextDB::DrawTextWithFont(const char* str_content, float x, float y, TTF_Font* font, int r, int g, int b, int a) {
+    if (str_content[0] == '\0') {
+        return;
     }
-    else {
-        LoadFont(font_name, font_size);
+    ALLOC_SCOPE(TAG_TEXT);
+    if (headless) {
+        draw_count++;
+        return;
     }
 
-    TTF_Font* currentFont = fonts[font_name][font_size];
     SDL_Color color;
     color.r = r;
     color.g = g;
     color.b = b;
     color.a = a;
 
-    SDL_Surface* text_surface = TTF_RenderText_Solid(currentFont, str_content.c_str(),color);
-    SDL_Texture* text_texture = SDL_CreateTextureFromSurface(renderer, text_surface);
+    SDL_Surface* text_surface = TTF_RenderText_Solid(font, str_content, color);
     float tempWidth = static_cast<float>(text_surface->w);
     float tempHeight = static_cast<float>(text_surface->h);
     SDL_FRect text_rect = { x, y, tempWidth, tempHeight };
     SDL_FPoint center;
     center.x = text_rect.w / 2.0f;
     center.y = text_rect.h / 2.0f;
-    displayText.push({ text_texture,text_rect,center });
-    SDL_FreeSurface(text_surface);
+    displayText[write_list].push_back({ text_surface,text_rect,center });
+}
+
+void TextDB::SubmitFrame() {
+    std::swap(write_list, ready_list);
+}
+
+void TextDB::AcquireFrame() {
+    std::swap(ready_list, render_list);
 }
 
 void TextDB::showText() {
-    while (!displayText.empty()) {
-        TextType& value = displayText.front();
-        Helper::SDL_RenderCopyEx(-1, "text", renderer, value.texture, nullptr, &value.rect, 0.0, &value.center, SDL_FLIP_NONE);
-        SDL_DestroyTexture(value.texture);
-        displayText.pop();
-   }
+    PROFILE_SCOPE("TextDB::showText");
+    for (TextType& value : displayText[render_list]) {
+        SDL_Texture* text_texture = SDL_CreateTextureFromSurface(renderer, value.surface);
+        Helper::SDL_RenderCopyEx(-1, "text", renderer, text_texture, nullptr, &value.rect, 0.0, &value.center, SDL_FLIP_NONE);
+        SDL_DestroyTexture(text_texture);
+        SDL_FreeSurface(value.surface);
+    }
+    last_text_textures = static_cast<int>(displayText[render_list].size());
+    displayText[render_list].clear();
 }
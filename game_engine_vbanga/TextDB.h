@@ -5,24 +5,42 @@
 #include "SDL.h"
 #include "SDL_ttf.h"
 #include <filesystem>
-#include <queue>
+#include <vector>
+#include <atomic>
 
 
 class TextDB {
 private:
     //static TTF_Font* currentFont;
+    //Text is rasterised when it's drawn, but only turned into a texture on the render thread
     struct TextType {
-        SDL_Texture* texture;
+        SDL_Surface* surface;
         SDL_FRect rect;
         SDL_FPoint center;
     };
     static std::unordered_map<std::string, std::unordered_map<int, TTF_Font*>> fonts;
     static SDL_Renderer* renderer;
-    static std::queue<TextType> displayText;
+    //Write, ready and render lists, handed over alongside ImageDB's
+    static std::vector<TextType> displayText[3];
+    static int write_list;
+    static int ready_list;
+    static int render_list;
+    static bool headless;
+    static size_t draw_count;
+    static std::atomic<int> last_text_textures;
 public:
     static void setRenderer(SDL_Renderer* render) { renderer = render; }
+    //With no renderer, fonts are checked for (so a missing one is still an error) but never opened, and draws are only counted
+    static void setHeadless(bool val) { headless = val; }
+    static size_t getDrawCount() { return draw_count; }
+    //Textures showText created (and destroyed) for the last frame it drew
+    static int getLastTextTextures() { return last_text_textures; }
     static void LoadFont(const std::string& font_name, const int& font_size);
+    static TTF_Font* GetFont(const std::string& font_name, int font_size);
     static void DrawText(std::string str_content, float x, float y, std::string font_name, int font_size, int r, int g, int b, int a);
+    static void DrawTextWithFont(const char* str_content, float x, float y, TTF_Font* font, int r, int g, int b, int a);
+    static void SubmitFrame();
+    static void AcquireFrame();
     static void showText();
 };
 
@@ -0,0 +1,121 @@
+#include "Timers.h"
+#include "CoroutineScheduler.h"
+#include "ActorDB.h"
+#include "Helper.h"
+#include <iostream>
+#include <algorithm>
+
+lua_State* Timers::lua_state = nullptr;
+std::unordered_map<int, Timers::Timer> Timers::timers;
+TimingWheel<int> Timers::wheel;
+std::vector<int> Timers::due;
+int Timers::next_id = 1;
+std::unordered_map<const ActorDB*, std::vector<int>> Timers::owned_timers;
+
+void Timers::Init(lua_State* L) {
+	lua_state = L;
+}
+
+int Timers::SetTimeout(lua_State* L) {
+	return Create(L, false);
+}
+
+int Timers::SetInterval(lua_State* L) {
+	return Create(L, true);
+}
+
+int Timers::Create(lua_State* L, bool repeating) {
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	lua_Integer frames = luaL_checkinteger(L, 2);
+	//A timeout of 0 fires in this frame's dispatch, an interval has to wait at least a frame
+	frames = std::max<lua_Integer>(frames, repeating ? 1 : 0);
+
+	Timer timer;
+	lua_pushvalue(L, 1);
+	timer.function_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	timer.interval = repeating ? static_cast<int>(frames) : 0;
+	timer.due = static_cast<uint64_t>(Helper::GetFrameNumber()) + static_cast<uint64_t>(frames);
+	timer.owner = CoroutineScheduler::GetOwner();
+
+	int id = next_id++;
+	timers.emplace(id, timer);
+	wheel.Schedule(timer.due, id);
+	if (timer.owner) {
+		owned_timers[timer.owner].push_back(id);
+	}
+
+	lua_pushinteger(L, id);
+	return 1;
+}
+
+int Timers::ClearTimer(lua_State* L) {
+	Clear(static_cast<int>(luaL_checkinteger(L, 1)));
+	return 0;
+}
+
+void Timers::Clear(int id) {
+	//The wheel entry is left behind and skipped when it comes due
+	auto it = timers.find(id);
+	if (it == timers.end()) return;
+	luaL_unref(lua_state, LUA_REGISTRYINDEX, it->second.function_ref);
+	auto owned = owned_timers.find(it->second.owner);
+	if (owned != owned_timers.end()) {
+		std::vector<int>& ids = owned->second;
+		auto position = std::find(ids.begin(), ids.end(), id);
+		if (position != ids.end()) {
+			*position = ids.back();
+			ids.pop_back();
+		}
+		if (ids.empty()) owned_timers.erase(owned);
+	}
+	timers.erase(it);
+}
+
+void Timers::ClearOwnedBy(const ActorDB* owner) {
+	auto owned = owned_timers.find(owner);
+	if (owned == owned_timers.end()) return;
+	//Taken out of the index first, since Clear takes each one out of it as well
+	std::vector<int> ids = std::move(owned->second);
+	owned_timers.erase(owned);
+	for (int id : ids) {
+		Clear(id);
+	}
+}
+
+void Timers::Dispatch() {
+	//Advanced even with no timers (an empty wheel just jumps to now), so the first timer after a quiet
+	//spell doesn't make the wheel walk through every frame it missed
+	uint64_t now = static_cast<uint64_t>(Helper::GetFrameNumber());
+	due.clear();
+	wheel.Advance(now, due);
+	if (due.empty()) return;
+
+	ActorDB* previous_owner = CoroutineScheduler::GetOwner();
+	for (size_t i = 0; i < due.size(); i++) {
+		auto it = timers.find(due[i]);
+		if (it == timers.end()) continue;
+		ActorDB* owner = it->second.owner;
+
+		//The function is on the stack before the timer is touched, so the callback can clear it
+		lua_rawgeti(lua_state, LUA_REGISTRYINDEX, it->second.function_ref);
+		if (it->second.interval > 0) {
+			it->second.due = now + static_cast<uint64_t>(it->second.interval);
+			wheel.Schedule(it->second.due, due[i]);
+		}
+		else {
+			Clear(due[i]);
+		}
+
+		//Coroutines and timers started from the callback belong to the same actor
+		CoroutineScheduler::SetOwner(owner);
+		if (lua_pcall(lua_state, 0, 0, 0) != LUA_OK) {
+			const char* message = lua_tostring(lua_state, -1);
+			std::string error_message = message ? message : "error object is not a string";
+			lua_pop(lua_state, 1);
+			std::replace(error_message.begin(), error_message.end(), '\\', '/');
+			std::string name = owner ? owner->getName() : "timer";
+			std::cout << "\033[31m" << name << " : " << error_message << "\033[0m" << std::endl;
+		}
+	}
+	CoroutineScheduler::SetOwner(previous_owner);
+}
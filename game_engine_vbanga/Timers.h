@@ -0,0 +1,43 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "lua/lua.hpp"
+#include "TimingWheel.h"
+
+class ActorDB;
+
+//One-shot and repeating script callbacks counted in frames. Timers sit in a hierarchical timing
+//wheel and Dispatch() runs the ones that are due between update and lateUpdate, so a pending
+//cooldown costs nothing until the frame it fires. Like coroutines, a timer belongs to the actor
+//whose callback created it and is cleared when that actor is destroyed.
+class Timers
+{
+private:
+	struct Timer {
+		int function_ref = LUA_NOREF;
+		int interval = 0; //0 for SetTimeout
+		uint64_t due = 0;
+		ActorDB* owner = nullptr;
+	};
+
+	static lua_State* lua_state;
+	static std::unordered_map<int, Timer> timers;
+	static TimingWheel<int> wheel;
+	static std::vector<int> due;
+	static int next_id;
+	//Each actor's timers, so destroying an actor only touches its own
+	static std::unordered_map<const ActorDB*, std::vector<int>> owned_timers;
+
+	static int Create(lua_State* L, bool repeating);
+	static void Clear(int id);
+public:
+	static void Init(lua_State* L);
+	static void Dispatch();
+	static void ClearOwnedBy(const ActorDB* owner);
+	static size_t GetCount() { return timers.size(); }
+
+	//Lua API, registered under Application
+	static int SetTimeout(lua_State* L);
+	static int SetInterval(lua_State* L);
+	static int ClearTimer(lua_State* L);
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//Hierarchical timing wheel. Level 0 has one bucket per tick for the next 64 ticks, and each level
+//above covers 64 times the range of the one below it. An item is filed in the lowest level that can
+//hold it and cascades down a level each time the wheel reaches its bucket, so scheduling is O(1)
+//and advancing a tick only touches the buckets that tick owns, however far out the items are.
+template <typename T>
+class TimingWheel
+{
+private:
+	static const int SLOT_BITS = 6;
+	static const uint64_t SLOT_COUNT = 1ull << SLOT_BITS;
+	static const uint64_t SLOT_MASK = SLOT_COUNT - 1;
+	static const int LEVEL_COUNT = 4;
+
+	struct Entry {
+		uint64_t due;
+		T item;
+	};
+
+	std::vector<Entry> levels[LEVEL_COUNT][SLOT_COUNT];
+	std::vector<Entry> overflow; //Further out than all the levels put together
+	std::vector<Entry> cascading;
+	uint64_t current = 0;
+	size_t count = 0;
+
+	void Place(const Entry& entry) {
+		//The highest bit group where due and current differ picks the level
+		uint64_t differing = entry.due ^ current;
+		for (int level = 0; level < LEVEL_COUNT; level++) {
+			if ((differing >> (SLOT_BITS * (level + 1))) == 0) {
+				levels[level][(entry.due >> (SLOT_BITS * level)) & SLOT_MASK].push_back(entry);
+				return;
+			}
+		}
+		overflow.push_back(entry);
+	}
+
+	void Cascade(std::vector<Entry>& bucket) {
+		if (bucket.empty()) return;
+		cascading.swap(bucket);
+		for (const Entry& entry : cascading) Place(entry);
+		cascading.clear();
+	}
+
+public:
+	void Reset(uint64_t now) {
+		for (auto& level : levels) {
+			for (auto& bucket : level) bucket.clear();
+		}
+		overflow.clear();
+		current = now;
+		count = 0;
+	}
+
+	//An empty wheel has nothing to walk through, so it can jump straight to now. Call this before
+	//scheduling on a wheel that may have sat idle, or the next Advance walks every tick it missed.
+	void SkipIdle(uint64_t now) {
+		if (count == 0 && now > current) current = now;
+	}
+
+	//Anything due now or in the past fires on the next Advance
+	void Schedule(uint64_t due, const T& item) {
+		if (due <= current) due = current + 1;
+		Place({ due, item });
+		count++;
+	}
+
+	//Appends everything due at or before now to out, in due order
+	void Advance(uint64_t now, std::vector<T>& out) {
+		while (current < now) {
+			if (count == 0) {
+				current = now;
+				return;
+			}
+			current++;
+
+			//Top down, so an item can fall through several levels on the same tick
+			if ((current & ((1ull << (SLOT_BITS * LEVEL_COUNT)) - 1)) == 0) {
+				Cascade(overflow);
+			}
+			for (int level = LEVEL_COUNT - 1; level > 0; level--) {
+				if ((current & ((1ull << (SLOT_BITS * level)) - 1)) == 0) {
+					Cascade(levels[level][(current >> (SLOT_BITS * level)) & SLOT_MASK]);
+				}
+			}
+
+			std::vector<Entry>& bucket = levels[0][current & SLOT_MASK];
+			for (const Entry& entry : bucket) out.push_back(entry.item);
+			count -= bucket.size();
+			bucket.clear();
+		}
+	}
+
+	size_t Size() const { return count; }
+	bool Empty() const { return count == 0; }
+};
@@ -0,0 +1,158 @@
+//Microbenchmark for the LuaFastBindings approach. It binds the same engine-shaped functions twice,
+//once through luabridge the way SceneDB::loadComponents used to and once as raw lua_CFunctions
+//with NameCache, then times a Lua loop calling each. The functions only record their arguments,
+//so the difference between the two columns is the binding cost itself.
+//
+//Build and run from game_engine_vbanga with: make bench
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "lua/lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+#include "LuaFastBindings.h"
+
+struct DrawCall {
+	int texture;
+	float values[12];
+};
+
+static std::vector<DrawCall> draw_calls;
+static std::unordered_map<std::string, int> textures = { {"player", 1}, {"enemy", 2}, {"bullet", 3} };
+static std::unordered_map<std::string, int> keys = { {"up", 82}, {"down", 81}, {"space", 44} };
+static NameCache<int> texture_cache;
+static NameCache<int> key_cache;
+
+static int LookupTexture(const std::string& name) {
+	auto it = textures.find(name);
+	return it != textures.end() ? it->second : 0;
+}
+
+static int LookupKey(const std::string& name) {
+	auto it = keys.find(name);
+	return it != keys.end() ? it->second : 0;
+}
+
+//luabridge versions, same signatures as ImageDB and Input
+static void BridgeDraw(const std::string& image_name, float x, float y) {
+	draw_calls.push_back({ LookupTexture(image_name), { x, y } });
+}
+
+static void BridgeDrawEx(const std::string& image_name, float x, float y, float rotation_degrees, float scale_x, float scale_y, float pivot_x, float pivot_y, float r, float g, float b, float a, float sorting_order) {
+	draw_calls.push_back({ LookupTexture(image_name), { x, y, rotation_degrees, scale_x, scale_y, pivot_x, pivot_y, r, g, b, a, sorting_order } });
+}
+
+static bool BridgeGetKey(std::string keycode) {
+	return LookupKey(keycode) == 44;
+}
+
+static int BridgeGetFrame() {
+	return static_cast<int>(draw_calls.size());
+}
+
+//Raw versions, written the way LuaFastBindings.cpp is
+static int CheckTexture(lua_State* L, int index) {
+	size_t length = 0;
+	const char* name = luaL_checklstring(L, index, &length);
+	return texture_cache.Get(name, length, 0, [](const std::string& image_name, int) { return LookupTexture(image_name); });
+}
+
+static inline float CheckFloat(lua_State* L, int index) {
+	int is_number = 0;
+	lua_Number value = lua_tonumberx(L, index, &is_number);
+	if (!is_number) luaL_typeerror(L, index, "number");
+	return static_cast<float>(value);
+}
+
+static int FastDraw(lua_State* L) {
+	int texture = CheckTexture(L, 1);
+	draw_calls.push_back({ texture, { CheckFloat(L, 2), CheckFloat(L, 3) } });
+	return 0;
+}
+
+static int FastDrawEx(lua_State* L) {
+	DrawCall call;
+	call.texture = CheckTexture(L, 1);
+	for (int i = 0; i < 12; i++) {
+		call.values[i] = CheckFloat(L, i + 2);
+	}
+	draw_calls.push_back(call);
+	return 0;
+}
+
+static int FastGetKey(lua_State* L) {
+	size_t length = 0;
+	const char* keycode = luaL_checklstring(L, 1, &length);
+	lua_pushboolean(L, key_cache.Get(keycode, length, 0, [](const std::string& name, int) { return LookupKey(name); }) == 44);
+	return 1;
+}
+
+static int FastGetFrame(lua_State* L) {
+	lua_pushinteger(L, static_cast<lua_Integer>(draw_calls.size()));
+	return 1;
+}
+
+static double TimeLoop(lua_State* L, const char* body, int iterations) {
+	std::string chunk = "local n = ... for i = 1, n do " + std::string(body) + " end";
+	if (luaL_loadstring(L, chunk.c_str()) != LUA_OK) {
+		std::printf("bad benchmark chunk: %s\n", lua_tostring(L, -1));
+		return 0.0;
+	}
+	lua_pushinteger(L, iterations);
+	draw_calls.clear();
+	auto start = std::chrono::steady_clock::now();
+	if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+		std::printf("benchmark failed: %s\n", lua_tostring(L, -1));
+		lua_pop(L, 1);
+		return 0.0;
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+	draw_calls.reserve(iterations);
+
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+	luabridge::getGlobalNamespace(L)
+		.beginNamespace("Bridge")
+		.addFunction("Draw", BridgeDraw)
+		.addFunction("DrawEx", BridgeDrawEx)
+		.addFunction("GetKey", BridgeGetKey)
+		.addFunction("GetFrame", BridgeGetFrame)
+		.endNamespace()
+		.beginNamespace("Fast")
+		.addCFunction("Draw", FastDraw)
+		.addCFunction("DrawEx", FastDrawEx)
+		.addCFunction("GetKey", FastGetKey)
+		.addCFunction("GetFrame", FastGetFrame)
+		.endNamespace();
+
+	struct Case {
+		const char* name;
+		const char* bridge;
+		const char* fast;
+	};
+	const Case cases[] = {
+		{ "Image.Draw", "Bridge.Draw('player', i, 2)", "Fast.Draw('player', i, 2)" },
+		{ "Image.DrawEx", "Bridge.DrawEx('enemy', i, 2, 45, 1, 1, 0.5, 0.5, 255, 255, 255, 255, 0)",
+			"Fast.DrawEx('enemy', i, 2, 45, 1, 1, 0.5, 0.5, 255, 255, 255, 255, 0)" },
+		{ "Input.GetKey", "Bridge.GetKey('space')", "Fast.GetKey('space')" },
+		{ "Application.GetFrame", "Bridge.GetFrame()", "Fast.GetFrame()" },
+	};
+
+	std::printf("%d calls each\n", iterations);
+	std::printf("%-22s %12s %12s %8s\n", "api", "luabridge ns", "raw ns", "speedup");
+	for (const Case& c : cases) {
+		double bridge = TimeLoop(L, c.bridge, iterations);
+		double fast = TimeLoop(L, c.fast, iterations);
+		std::printf("%-22s %12.1f %12.1f %7.2fx\n", c.name, bridge, fast, fast > 0 ? bridge / fast : 0.0);
+	}
+
+	lua_close(L);
+	return 0;
+}
@@ -0,0 +1,294 @@
+//Microbenchmark for crossing the C++/Lua boundary the ways the engine does every frame:
+//  C++ -> Lua   calling a component function through LuaRef, the way ActorDB::update does, against
+//               a cached LuaRef and a raw lua_pcall
+//  Lua -> C++   luabridge functions taking strings, floats and b2Vec2 userdata, Vector2 methods,
+//               properties and construction, against raw lua_CFunctions
+//  table reads  fields of a component instance, own and inherited through the __index metatable
+//               SceneDB::EstablishInheritance sets up, from Lua and through LuaRef
+//  newTable     table creation from C++ and Lua, and a full component instance as SceneDB builds one
+//Each case reports nanoseconds per operation. --json writes them out, and --baseline compares
+//against an earlier --json file, failing if any case got slower by more than --threshold percent.
+//
+//Build and run from game_engine_vbanga with: make bench (make bench-baseline stores a new baseline)
+//Options: [iterations] --json <file> --baseline <file> --threshold <percent>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "lua/lua.hpp"
+#include "LuaBridge/LuaBridge.h"
+#include "box2d/b2_math.h"
+#include "include/rapidjson/document.h"
+
+static volatile float float_sink = 0.0f;
+static volatile size_t size_sink = 0;
+
+//luabridge versions, shaped like the engine's bindings
+static float BridgeFloats(float x, float y) {
+	return x + y;
+}
+
+static int BridgeString(const std::string& name) {
+	return static_cast<int>(name.size());
+}
+
+static float BridgeVector(const b2Vec2& v) {
+	return v.x + v.y;
+}
+
+//Raw versions of the same
+static int RawFloats(lua_State* L) {
+	float x = static_cast<float>(luaL_checknumber(L, 1));
+	float y = static_cast<float>(luaL_checknumber(L, 2));
+	lua_pushnumber(L, x + y);
+	return 1;
+}
+
+static int RawString(lua_State* L) {
+	size_t length = 0;
+	luaL_checklstring(L, 1, &length);
+	lua_pushinteger(L, static_cast<lua_Integer>(length));
+	return 1;
+}
+
+//Same as SceneDB::EstablishInheritance
+static void EstablishInheritance(lua_State* L, luabridge::LuaRef& instance_table, luabridge::LuaRef& parent_table) {
+	luabridge::LuaRef new_metatable = luabridge::newTable(L);
+	new_metatable["__index"] = parent_table;
+	instance_table.push(L);
+	new_metatable.push(L);
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1);
+}
+
+static double TimeLua(lua_State* L, const char* setup, const char* body, int iterations) {
+	std::string chunk = "local n = ... " + std::string(setup) + " for i = 1, n do " + std::string(body) + " end";
+	if (luaL_loadstring(L, chunk.c_str()) != LUA_OK) {
+		std::printf("bad benchmark chunk: %s\n", lua_tostring(L, -1));
+		lua_pop(L, 1);
+		return 0.0;
+	}
+	lua_pushinteger(L, iterations);
+	auto start = std::chrono::steady_clock::now();
+	if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+		std::printf("benchmark failed: %s\n", lua_tostring(L, -1));
+		lua_pop(L, 1);
+		return 0.0;
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+static double TimeNative(const std::function<void(int)>& body, int iterations) {
+	auto start = std::chrono::steady_clock::now();
+	try {
+		body(iterations);
+	}
+	catch (const luabridge::LuaException& e) {
+		std::printf("benchmark failed: %s\n", e.what());
+		return 0.0;
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+struct Result {
+	std::string group;
+	std::string name;
+	double ns;
+};
+
+int main(int argc, char* argv[]) {
+	int iterations = 1000000;
+	std::string json_path;
+	std::string baseline_path;
+	double threshold = 15.0;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if (arg == "--json" && has_value) json_path = argv[++i];
+		else if (arg == "--baseline" && has_value) baseline_path = argv[++i];
+		else if (arg == "--threshold" && has_value) threshold = std::atof(argv[++i]);
+		else iterations = std::atoi(argv[i]);
+	}
+	if (iterations <= 0) {
+		std::printf("usage: boundary_bench [iterations] [--json file] [--baseline file] [--threshold percent]\n");
+		return 1;
+	}
+
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+	luabridge::getGlobalNamespace(L)
+		.beginClass<b2Vec2>("Vector2")
+		.addConstructor<void(*) (float, float)>()
+		.addProperty("x", &b2Vec2::x)
+		.addProperty("y", &b2Vec2::y)
+		.addFunction("Length", &b2Vec2::Length)
+		.addFunction("AddInPlace", &b2Vec2::AddInPlace)
+		.endClass()
+		.beginNamespace("Bridge")
+		.addFunction("Floats", BridgeFloats)
+		.addFunction("String", BridgeString)
+		.addFunction("Vector", BridgeVector)
+		.endNamespace()
+		.beginNamespace("Raw")
+		.addCFunction("Floats", RawFloats)
+		.addCFunction("String", RawString)
+		.endNamespace();
+
+	//A component type and one instance of it, built the way SceneDB::loadValues does
+	if (luaL_dostring(L,
+		"BenchComponent = {\n"
+		"	speed = 5, name = 'bench', count = 0,\n"
+		"	OnUpdate = function(self) self.count = self.count + 1 end\n"
+		"}\n"
+		"plain = { speed = 5, name = 'bench', count = 0 }\n") != LUA_OK) {
+		std::printf("setup failed: %s\n", lua_tostring(L, -1));
+		return 1;
+	}
+	luabridge::LuaRef component_type = luabridge::getGlobal(L, "BenchComponent");
+	luabridge::LuaRef component = luabridge::newTable(L);
+	EstablishInheritance(L, component, component_type);
+	component["key"] = std::string("1");
+	component["enabled"] = true;
+	luabridge::setGlobal(L, component, "instance");
+
+	std::vector<Result> results;
+	auto run_lua = [&](const char* group, const char* name, const char* setup, const char* body) {
+		results.push_back({ group, name, TimeLua(L, setup, body, iterations) });
+	};
+	auto run_native = [&](const char* group, const char* name, const std::function<void(int)>& body) {
+		results.push_back({ group, name, TimeNative(body, iterations) });
+	};
+
+	//C++ -> Lua
+	run_native("C++ -> Lua", "lookup + call (ActorDB::update)", [&](int n) {
+		for (int i = 0; i < n; i++) {
+			if (component["OnUpdate"].isFunction()) {
+				component["OnUpdate"](component);
+			}
+		}
+		});
+	luabridge::LuaRef on_update = component["OnUpdate"];
+	run_native("C++ -> Lua", "cached LuaRef call", [&](int n) {
+		for (int i = 0; i < n; i++) {
+			on_update(component);
+		}
+		});
+	on_update.push(L);
+	int function_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	component.push(L);
+	int component_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	run_native("C++ -> Lua", "raw lua_pcall", [&](int n) {
+		for (int i = 0; i < n; i++) {
+			lua_rawgeti(L, LUA_REGISTRYINDEX, function_ref);
+			lua_rawgeti(L, LUA_REGISTRYINDEX, component_ref);
+			if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+				lua_pop(L, 1);
+			}
+		}
+		});
+
+	//Lua -> C++
+	run_lua("Lua -> C++", "float args (luabridge)", "", "Bridge.Floats(i, 2.5)");
+	run_lua("Lua -> C++", "float args (raw)", "", "Raw.Floats(i, 2.5)");
+	run_lua("Lua -> C++", "string arg (luabridge)", "", "Bridge.String('player')");
+	run_lua("Lua -> C++", "string arg (raw)", "", "Raw.String('player')");
+	run_lua("Lua -> C++", "b2Vec2 arg (luabridge)", "local v = Vector2(3, 4)", "Bridge.Vector(v)");
+	run_lua("Lua -> C++", "b2Vec2 method v:Length()", "local v = Vector2(3, 4)", "v:Length()");
+	run_lua("Lua -> C++", "b2Vec2 method v:AddInPlace(w)", "local v = Vector2(3, 4) local w = Vector2(0, 0)", "v:AddInPlace(w)");
+	run_lua("Lua -> C++", "b2Vec2 property v.x", "local v = Vector2(3, 4) local x", "x = v.x");
+	run_lua("Lua -> C++", "b2Vec2 construct Vector2(x, y)", "", "Vector2(i, 2)");
+
+	//Table reads
+	run_lua("table reads", "plain table field", "local t = plain local x", "x = t.speed");
+	run_lua("table reads", "own field on instance", "local t = instance local x", "x = t.key");
+	run_lua("table reads", "inherited through __index", "local t = instance local x", "x = t.speed");
+	run_lua("table reads", "missing through __index", "local t = instance local x", "x = t.missing");
+	run_native("table reads", "LuaRef own field", [&](int n) {
+		for (int i = 0; i < n; i++) {
+			size_sink = size_sink + component["enabled"].isBool();
+		}
+		});
+	run_native("table reads", "LuaRef inherited field", [&](int n) {
+		for (int i = 0; i < n; i++) {
+			float_sink = component["speed"].cast<float>();
+		}
+		});
+
+	//Table creation
+	run_native("newTable", "luabridge::newTable", [&](int n) {
+		for (int i = 0; i < n; i++) {
+			luabridge::LuaRef table = luabridge::newTable(L);
+		}
+		});
+	run_native("newTable", "lua_createtable", [&](int n) {
+		for (int i = 0; i < n; i++) {
+			lua_createtable(L, 0, 0);
+			lua_pop(L, 1);
+		}
+		});
+	run_lua("newTable", "Lua {}", "local t", "t = {}");
+	run_native("newTable", "component instance (SceneDB)", [&](int n) {
+		for (int i = 0; i < n; i++) {
+			luabridge::LuaRef instance = luabridge::newTable(L);
+			EstablishInheritance(L, instance, component_type);
+			instance["key"] = std::string("1");
+			instance["enabled"] = true;
+		}
+		});
+
+	std::printf("%d iterations each\n", iterations);
+	std::printf("%-12s %-34s %10s\n", "group", "case", "ns/op");
+	for (const Result& result : results) {
+		std::printf("%-12s %-34s %10.1f\n", result.group.c_str(), result.name.c_str(), result.ns);
+	}
+
+	if (!json_path.empty()) {
+		std::ofstream json(json_path);
+		json << "{\n\"iterations\": " << iterations << ",\n\"ns_per_op\": {";
+		for (size_t i = 0; i < results.size(); i++) {
+			json << (i == 0 ? "\n" : ",\n") << "\"" << results[i].group << ": " << results[i].name << "\": " << results[i].ns;
+		}
+		json << "\n}\n}\n";
+		std::printf("results written to %s\n", json_path.c_str());
+	}
+
+	int regressions = 0;
+	if (!baseline_path.empty()) {
+		std::ifstream file(baseline_path);
+		std::stringstream contents;
+		contents << file.rdbuf();
+		rapidjson::Document baseline;
+		if (!file || baseline.Parse(contents.str().c_str()).HasParseError() || !baseline.HasMember("ns_per_op")) {
+			std::printf("no baseline at %s\n", baseline_path.c_str());
+		}
+		else {
+			std::printf("\ncompared with baseline (regression threshold %.0f%%):\n", threshold);
+			const rapidjson::Value& before = baseline["ns_per_op"];
+			for (const Result& result : results) {
+				std::string key = result.group + ": " + result.name;
+				if (!before.HasMember(key.c_str())) continue;
+				double then = before[key.c_str()].GetDouble();
+				double change = then > 0.0 ? (result.ns - then) / then * 100.0 : 0.0;
+				bool regressed = change > threshold;
+				regressions += regressed;
+				std::printf("%-47s %10.1f %10.1f %+8.1f%%%s\n", key.c_str(), then, result.ns, change, regressed ? "  REGRESSED" : "");
+			}
+		}
+	}
+
+	luaL_unref(L, LUA_REGISTRYINDEX, function_ref);
+	luaL_unref(L, LUA_REGISTRYINDEX, component_ref);
+	on_update = luabridge::LuaRef(L);
+	component = luabridge::LuaRef(L);
+	component_type = luabridge::LuaRef(L);
+	lua_close(L);
+	if (regressions > 0) std::printf("%d case(s) regressed past %.0f%%\n", regressions, threshold);
+	return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,351 @@
+//Stress scene benchmark suite. It generates a set of small games under bench/stress, each one
+//hammering a single part of the engine, runs each of them headless for a fixed number of frames
+//with --bench, and collects the BenchReport results into bench/stress_results.json:
+//  actors_empty     N actors whose only component is an empty Lua table
+//  actors_trivial   N actors with an OnUpdate that bumps a counter
+//  physics_pile     M dynamic boxes dropped into a pile on a static floor
+//  particles        K particle systems bursting every frame
+//  text_heavy       one actor drawing lots of text every frame
+//  sprites_heavy    one actor drawing lots of sprites every frame
+//  churn            Instantiate/Destroy of short-lived actors every frame
+//Given a baseline (a results file saved from an earlier run with --save-baseline), every metric is
+//compared against it and the run fails if frame time, allocations or Lua memory regressed by more
+//than the threshold.
+//
+//Build and run from game_engine_vbanga with: make bench (make bench-baseline stores a new baseline)
+//Options: --engine <path> --frames <n> --scale <x> --only <scene> --baseline <file>
+//         --save-baseline <file> --threshold <percent>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "include/rapidjson/document.h"
+#include "include/rapidjson/filereadstream.h"
+
+namespace fs = std::filesystem;
+
+const char* const STRESS_DIR = "bench/stress";
+const char* const RESULTS_FILENAME = "bench/stress_results.json";
+
+struct Metric {
+	const char* name;
+	//Only these are judged against the baseline; the rest are there to explain a change
+	bool compared;
+};
+
+const Metric METRICS[] = {
+	{ "mean_ms", true },
+	{ "p50_ms", false },
+	{ "p99_ms", true },
+	{ "max_ms", false },
+	{ "allocations_per_frame", true },
+	{ "bytes_per_frame", false },
+	{ "lua_peak_kb", true },
+	{ "actors", false },
+};
+
+struct StressScene {
+	std::string name;
+	std::string description;
+	//Fills in the scene's actors and writes whatever component types and templates it needs
+	std::function<std::string(const fs::path& resources)> generate;
+};
+
+static void WriteFile(const fs::path& path, const std::string& contents) {
+	fs::create_directories(path.parent_path());
+	std::ofstream file(path, std::ios::binary);
+	file << contents;
+}
+
+static int Scaled(int count, double scale) {
+	return std::max(1, static_cast<int>(count * scale));
+}
+
+//Comma separated list of actor objects, each with the given components object
+static std::string ActorList(int count, const std::function<std::string(int)>& actor) {
+	std::ostringstream out;
+	for (int i = 0; i < count; i++) {
+		out << (i == 0 ? "\n\t\t" : ",\n\t\t") << actor(i);
+	}
+	return out.str();
+}
+
+static std::vector<StressScene> BuildSuite(double scale) {
+	std::vector<StressScene> suite;
+
+	int actors = Scaled(2000, scale);
+	suite.push_back({ "actors_empty", std::to_string(actors) + " actors, empty component",
+		[actors](const fs::path& resources) {
+			WriteFile(resources / "component_types" / "BenchEmpty.lua", "BenchEmpty = {}\n");
+			return ActorList(actors, [](int i) {
+				return "{ \"name\": \"empty" + std::to_string(i) + "\", \"components\": { \"1\": { \"type\": \"BenchEmpty\" } } }";
+				});
+		} });
+
+	suite.push_back({ "actors_trivial", std::to_string(actors) + " actors, trivial OnUpdate",
+		[actors](const fs::path& resources) {
+			WriteFile(resources / "component_types" / "BenchCounter.lua",
+				"BenchCounter = {\n"
+				"\tcount = 0,\n"
+				"\tOnUpdate = function(self)\n"
+				"\t\tself.count = self.count + 1\n"
+				"\tend\n"
+				"}\n");
+			return ActorList(actors, [](int i) {
+				return "{ \"name\": \"counter" + std::to_string(i) + "\", \"components\": { \"1\": { \"type\": \"BenchCounter\" } } }";
+				});
+		} });
+
+	int bodies = Scaled(500, scale);
+	suite.push_back({ "physics_pile", std::to_string(bodies) + " rigid bodies in a pile",
+		[bodies](const fs::path&) {
+			std::string floor = "{ \"name\": \"floor\", \"components\": { \"1\": { \"type\": \"Rigidbody\", \"body_type\": \"static\", \"x\": 0, \"y\": 20, \"width\": 200, \"height\": 1 } } }";
+			return "\n\t\t" + floor + "," + ActorList(bodies, [](int i) {
+				//Staggered columns so the boxes land on each other rather than straight down
+				float x = static_cast<float>(i % 25) * 1.1f - 13.0f + (i / 25 % 2) * 0.5f;
+				float y = 18.0f - static_cast<float>(i / 25) * 1.1f;
+				return "{ \"name\": \"box" + std::to_string(i) + "\", \"components\": { \"1\": { \"type\": \"Rigidbody\", \"x\": "
+					+ std::to_string(x) + ", \"y\": " + std::to_string(y) + " } } }";
+				});
+		} });
+
+	int systems = Scaled(40, scale);
+	suite.push_back({ "particles", std::to_string(systems) + " particle systems bursting every frame",
+		[systems](const fs::path&) {
+			return ActorList(systems, [](int i) {
+				return "{ \"name\": \"emitter" + std::to_string(i) + "\", \"components\": { \"1\": { \"type\": \"ParticleSystem\", \"x\": "
+					+ std::to_string(i % 10) + ", \"y\": " + std::to_string(i / 10)
+					+ ", \"frames_between_bursts\": 1, \"burst_quantity\": 20, \"duration_frames\": 120, \"start_speed_min\": 0.5, \"start_speed_max\": 2.0 } } }";
+				});
+		} });
+
+	int texts = Scaled(500, scale);
+	suite.push_back({ "text_heavy", std::to_string(texts) + " text draws per frame",
+		[texts](const fs::path& resources) {
+			//Headless runs only check that the font exists, so an empty file will do
+			WriteFile(resources / "fonts" / "bench.ttf", "");
+			WriteFile(resources / "component_types" / "BenchText.lua",
+				"BenchText = {\n"
+				"\tcount = " + std::to_string(texts) + ",\n"
+				"\tOnUpdate = function(self)\n"
+				"\t\tlocal frame = Application.GetFrame()\n"
+				"\t\tfor i = 1, self.count do\n"
+				"\t\t\tText.Draw(\"score \" .. (frame + i), i % 40 * 16, i // 40 * 16, \"bench\", 16, 255, 255, 255, 255)\n"
+				"\t\tend\n"
+				"\tend\n"
+				"}\n");
+			return ActorList(1, [](int) {
+				return std::string("{ \"name\": \"text\", \"components\": { \"1\": { \"type\": \"BenchText\" } } }");
+				});
+		} });
+
+	int sprites = Scaled(5000, scale);
+	suite.push_back({ "sprites_heavy", std::to_string(sprites) + " sprite draws per frame",
+		[sprites](const fs::path& resources) {
+			//Headless runs only check that the image exists, so an empty file will do
+			WriteFile(resources / "images" / "bench_sprite.png", "");
+			WriteFile(resources / "component_types" / "BenchSprites.lua",
+				"BenchSprites = {\n"
+				"\tcount = " + std::to_string(sprites) + ",\n"
+				"\tOnUpdate = function(self)\n"
+				"\t\tlocal frame = Application.GetFrame()\n"
+				"\t\tfor i = 1, self.count do\n"
+				"\t\t\tImage.DrawEx(\"bench_sprite\", i % 100, i // 100, frame + i, 1, 1, 0.5, 0.5, 255, 255, 255, 255, i % 3)\n"
+				"\t\tend\n"
+				"\tend\n"
+				"}\n");
+			return ActorList(1, [](int) {
+				return std::string("{ \"name\": \"sprites\", \"components\": { \"1\": { \"type\": \"BenchSprites\" } } }");
+				});
+		} });
+
+	int spawns = Scaled(20, scale);
+	suite.push_back({ "churn", std::to_string(spawns) + " actors instantiated and destroyed per frame",
+		[spawns](const fs::path& resources) {
+			WriteFile(resources / "component_types" / "BenchCounter.lua",
+				"BenchCounter = {\n"
+				"\tcount = 0,\n"
+				"\tOnUpdate = function(self)\n"
+				"\t\tself.count = self.count + 1\n"
+				"\tend\n"
+				"}\n");
+			WriteFile(resources / "actor_templates" / "BenchChurnActor.template",
+				"{ \"name\": \"churned\", \"components\": { \"1\": { \"type\": \"BenchCounter\" } } }\n");
+			//Each actor lives for 60 frames, so after warmup there is one destroy for every instantiate
+			WriteFile(resources / "component_types" / "BenchChurn.lua",
+				"BenchChurn = {\n"
+				"\tper_frame = " + std::to_string(spawns) + ",\n"
+				"\tlifetime = 60,\n"
+				"\tOnStart = function(self)\n"
+				"\t\tself.live = {}\n"
+				"\t\tself.head = 1\n"
+				"\t\tself.tail = 0\n"
+				"\tend,\n"
+				"\tOnUpdate = function(self)\n"
+				"\t\tfor i = 1, self.per_frame do\n"
+				"\t\t\tself.tail = self.tail + 1\n"
+				"\t\t\tself.live[self.tail] = Actor.Instantiate(\"BenchChurnActor\")\n"
+				"\t\tend\n"
+				"\t\twhile self.tail - self.head + 1 > self.per_frame * self.lifetime do\n"
+				"\t\t\tActor.Destroy(self.live[self.head])\n"
+				"\t\t\tself.live[self.head] = nil\n"
+				"\t\t\tself.head = self.head + 1\n"
+				"\t\tend\n"
+				"\tend\n"
+				"}\n");
+			return ActorList(1, [](int) {
+				return std::string("{ \"name\": \"spawner\", \"components\": { \"1\": { \"type\": \"BenchChurn\" } } }");
+				});
+		} });
+
+	return suite;
+}
+
+static bool ReadJson(const fs::path& path, rapidjson::Document& document) {
+	FILE* file = std::fopen(path.string().c_str(), "rb");
+	if (!file) return false;
+	char buffer[65536];
+	rapidjson::FileReadStream stream(file, buffer, sizeof(buffer));
+	document.ParseStream(stream);
+	std::fclose(file);
+	return !document.HasParseError() && document.IsObject();
+}
+
+static std::string Quote(const std::string& path) {
+	return "\"" + path + "\"";
+}
+
+//Generates the scene's game, runs it and returns its BenchReport, or an empty string if it failed
+static std::string RunScene(const StressScene& scene, const fs::path& engine, int frames) {
+	fs::path game_dir = fs::path(STRESS_DIR) / scene.name;
+	fs::remove_all(game_dir);
+	fs::path resources = game_dir / "resources";
+	std::string actors = scene.generate(resources);
+	WriteFile(resources / "game.config",
+		"{\n"
+		"\t\"game_title\": \"stress " + scene.name + "\",\n"
+		"\t\"initial_scene\": \"" + scene.name + "\",\n"
+		"\t\"headless\": true,\n"
+		"\t\"hitch_budget_ms\": 0\n"
+		"}\n");
+	WriteFile(resources / "scenes" / (scene.name + ".scene"), "{\n\t\"actors\": [" + actors + "\n\t]\n}\n");
+
+	fs::path result_path = game_dir / "result.json";
+	std::string command = "cd " + Quote(game_dir.string()) + " && " + Quote(engine.string())
+		+ " --headless --frames " + std::to_string(frames) + " --bench result.json > run.log 2>&1";
+	int status = std::system(command.c_str());
+	std::ifstream result(result_path);
+	if (status != 0 || !result) {
+		std::printf("%-16s failed, see %s\n", scene.name.c_str(), (game_dir / "run.log").string().c_str());
+		return "";
+	}
+	std::stringstream contents;
+	contents << result.rdbuf();
+	return contents.str();
+}
+
+static void PrintComparison(const rapidjson::Document& results, const rapidjson::Document& baseline, double threshold, int& regressions) {
+	std::printf("\ncompared with baseline (regression threshold %.0f%%):\n", threshold);
+	std::printf("%-16s %-22s %12s %12s %9s\n", "scene", "metric", "baseline", "now", "change");
+	for (auto scene = results["scenes"].MemberBegin(); scene != results["scenes"].MemberEnd(); ++scene) {
+		const char* name = scene->name.GetString();
+		if (!baseline["scenes"].HasMember(name)) {
+			std::printf("%-16s not in baseline\n", name);
+			continue;
+		}
+		const rapidjson::Value& before = baseline["scenes"][name];
+		for (const Metric& metric : METRICS) {
+			if (!scene->value.HasMember(metric.name) || !before.HasMember(metric.name)) continue;
+			double now = scene->value[metric.name].GetDouble();
+			double then = before[metric.name].GetDouble();
+			double change = then != 0.0 ? (now - then) / then * 100.0 : (now != 0.0 ? 100.0 : 0.0);
+			bool regressed = metric.compared && change > threshold;
+			regressions += regressed;
+			std::printf("%-16s %-22s %12.3f %12.3f %+8.1f%%%s\n", name, metric.name, then, now, change, regressed ? "  REGRESSED" : "");
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	fs::path engine = "./game_engine_linux";
+	int frames = 600;
+	double scale = 1.0;
+	std::string only;
+	std::string baseline_path;
+	std::string save_baseline_path;
+	double threshold = 10.0;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if (arg == "--engine" && has_value) engine = argv[++i];
+		else if (arg == "--frames" && has_value) frames = std::atoi(argv[++i]);
+		else if (arg == "--scale" && has_value) scale = std::atof(argv[++i]);
+		else if (arg == "--only" && has_value) only = argv[++i];
+		else if (arg == "--baseline" && has_value) baseline_path = argv[++i];
+		else if (arg == "--save-baseline" && has_value) save_baseline_path = argv[++i];
+		else if (arg == "--threshold" && has_value) threshold = std::atof(argv[++i]);
+		else {
+			std::printf("unknown argument %s\n", arg.c_str());
+			return 1;
+		}
+	}
+	if (!fs::exists(engine)) {
+		std::printf("error: engine %s missing, build it with make first\n", engine.string().c_str());
+		return 1;
+	}
+	engine = fs::absolute(engine);
+
+	std::ostringstream results_json;
+	results_json << "{\n\"frames\": " << frames << ",\n\"scale\": " << scale << ",\n\"scenes\": {";
+	bool first = true;
+	int failures = 0;
+	std::printf("%d frames per scene, scale %.2f\n", frames, scale);
+	std::printf("%-16s %-46s %9s %9s %9s %11s %10s\n", "scene", "load", "mean ms", "p50 ms", "p99 ms", "allocs/fr", "lua kb");
+	for (const StressScene& scene : BuildSuite(scale)) {
+		if (!only.empty() && scene.name != only) continue;
+		std::string result = RunScene(scene, engine, frames);
+		rapidjson::Document parsed;
+		if (result.empty() || parsed.Parse(result.c_str()).HasParseError()) {
+			failures++;
+			continue;
+		}
+		std::printf("%-16s %-46s %9.3f %9.3f %9.3f %11.1f %10.1f\n", scene.name.c_str(), scene.description.c_str(),
+			parsed["mean_ms"].GetDouble(), parsed["p50_ms"].GetDouble(), parsed["p99_ms"].GetDouble(),
+			parsed["allocations_per_frame"].GetDouble(), parsed["lua_peak_kb"].GetDouble());
+		results_json << (first ? "\n" : ",\n") << "\"" << scene.name << "\": " << result;
+		first = false;
+	}
+	results_json << "}\n}\n";
+	WriteFile(RESULTS_FILENAME, results_json.str());
+	std::printf("results written to %s\n", RESULTS_FILENAME);
+	if (!save_baseline_path.empty()) {
+		WriteFile(save_baseline_path, results_json.str());
+		std::printf("baseline saved to %s\n", save_baseline_path.c_str());
+	}
+
+	int regressions = 0;
+	if (!baseline_path.empty()) {
+		rapidjson::Document results;
+		rapidjson::Document baseline;
+		results.Parse(results_json.str().c_str());
+		if (!ReadJson(baseline_path, baseline) || !baseline.HasMember("scenes")) {
+			std::printf("no baseline at %s, run make bench-baseline to store one\n", baseline_path.c_str());
+		}
+		else {
+			if (baseline["frames"].GetInt() != frames || baseline["scale"].GetDouble() != scale) {
+				std::printf("warning: baseline was run with %d frames at scale %.2f\n", baseline["frames"].GetInt(), baseline["scale"].GetDouble());
+			}
+			PrintComparison(results, baseline, threshold, regressions);
+		}
+	}
+	if (failures > 0) std::printf("%d scene(s) failed to run\n", failures);
+	if (regressions > 0) std::printf("%d metric(s) regressed past %.0f%%\n", regressions, threshold);
+	return failures > 0 || regressions > 0 ? 1 : 0;
+}
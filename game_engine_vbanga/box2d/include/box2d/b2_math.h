@@ -146,6 +146,28 @@ struct B2_API b2Vec2
 		return send;
 	}
 
+	// In-place variants of the operators above. They write into this vector instead of
+	// returning a new one, so scripts can reuse a Vector2 without allocating userdata.
+	void AddInPlace(const b2Vec2& other) {
+		x += other.x;
+		y += other.y;
+	}
+
+	void SubInPlace(const b2Vec2& other) {
+		x -= other.x;
+		y -= other.y;
+	}
+
+	void MulInPlace(const float multiplier) {
+		x *= multiplier;
+		y *= multiplier;
+	}
+
+	void CopyFrom(const b2Vec2& other) {
+		x = other.x;
+		y = other.y;
+	}
+
 	float x, y;
 };
 
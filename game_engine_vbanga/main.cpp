@@ -22,12 +22,118 @@
 #include "TextDB.h"
 #include "AudioDB.h"
 #include "Input.h"
+#include "LuaProfiler.h"
+#include "Profiler.h"
+#include "HitchDetector.h"
+#include "EngineStats.h"
+#include "AllocTracker.h"
+#include "BenchReport.h"
+#include "StateHash.h"
+#include "ScriptWorkers.h"
+#include "JobSystem.h"
+#include "CoroutineScheduler.h"
+#include "Timers.h"
+#include "InputHooks.h"
+#include "InputActions.h"
+#include "FixedTimestep.h"
+#include "FramePacer.h"
+#include "FramePipeline.h"
+#include "FrameCapture.h"
+#include "RenderTrace.h"
+#include "InputRecording.h"
 #include "lua/lua.hpp"
 #include "LuaBridge/LuaBridge.h"
 #include "box2d/box2d.h"
 
+//Headless runs print how long their frames took however the run ends (--frames, Application.Quit or SDL_QUIT)
+static Uint64 headless_start_counter = 0;
+static Uint64 headless_last_counter = 0;
+static Uint64 headless_min_frame = UINT64_MAX;
+static Uint64 headless_max_frame = 0;
+static bool headless_summary = false;
+
+static void PrintHeadlessSummary() {
+	int frames = Helper::GetFrameNumber();
+	double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+	double total_seconds = static_cast<double>(headless_last_counter - headless_start_counter) / frequency;
+	std::cout << "headless: " << frames << " frames in " << total_seconds << " s";
+	if (frames > 0 && total_seconds > 0.0) {
+		std::cout << " (" << frames / total_seconds << " fps, avg " << total_seconds * 1000.0 / frames << " ms"
+			<< ", min " << headless_min_frame * 1000.0 / frequency << " ms"
+			<< ", max " << headless_max_frame * 1000.0 / frequency << " ms)";
+	}
+	std::cout << ", " << ImageDB::getDrawCount() << " image draws, " << TextDB::getDrawCount() << " text draws" << std::endl;
+}
+
+//Application.Quit() and the engine's error paths end the run with exit(), from whichever thread hit
+//them, so everything is torn down from this one handler in a fixed order: first whatever could still
+//be running engine code, then the logs and reports, which can then be written without racing it.
+static void ShutdownEngine() {
+	FramePipeline::Stop();
+	ScriptWorkers::Shutdown();
+	JobSystem::Shutdown();
+	FrameCapture::Shutdown();
+	//Before anything that allocates to write its output, which steady mode would fail the run over
+	AllocTracker::Shutdown();
+	RenderTrace::Shutdown();
+	InputRecording::Shutdown();
+	StateHash::Shutdown();
+	LuaProfiler::Shutdown();
+	Profiler::Shutdown();
+	BenchReport::Write();
+	if (headless_summary) {
+		PrintHeadlessSummary();
+	}
+}
+
 int main(int argc, char* argv[]) {
 
+	bool headless = false;
+	int max_frames = -1;
+	std::string bench_output;
+	bool replay_bench = false;
+	std::string game_dir;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--headless") {
+			headless = true;
+		}
+		else if (arg == "--frames" && i + 1 < argc) {
+			max_frames = std::atoi(argv[++i]);
+		}
+		else if (arg == "--bench" && i + 1 < argc) {
+			bench_output = argv[++i];
+		}
+		else if (arg == "--replay-bench" && i + 1 < argc) {
+			bench_output = argv[++i];
+			replay_bench = true;
+		}
+		else if (arg == "--game-dir" && i + 1 < argc) {
+			game_dir = argv[++i];
+		}
+	}
+
+	//Everything is loaded relative to the working directory, so pointing the engine at another game means moving there
+	if (!bench_output.empty()) {
+		bench_output = std::filesystem::absolute(bench_output).string();
+	}
+	if (!game_dir.empty()) {
+		if (!std::filesystem::is_directory(game_dir)) {
+			std::cout << "error: game directory " << game_dir << " missing";
+			exit(1);
+		}
+		std::filesystem::current_path(game_dir);
+	}
+	if (replay_bench) {
+		const char* recording = std::filesystem::exists(Helper::USER_INPUT_FILENAME) ? Helper::USER_INPUT_FILENAME : Helper::USER_INPUT_RECORDING_FILENAME;
+		if (!std::filesystem::exists(recording)) {
+			std::cout << "error: --replay-bench needs " << Helper::USER_INPUT_FILENAME << " or " << Helper::USER_INPUT_RECORDING_FILENAME << " to replay";
+			exit(1);
+		}
+		Helper::_replay_benchmark_mode = true;
+		BenchReport::SetSource((std::filesystem::current_path() / recording).string());
+	}
+
 	//Check for a resources directory
 
 	const std::string resourcesDir{ "resources" };
@@ -53,8 +159,23 @@ int main(int argc, char* argv[]) {
 		renderingExists = true;
 	}
 
+	if (config.HasMember("headless")) {
+		headless = headless || config["headless"].GetBool();
+	}
+	if (headless) {
+		//The dummy drivers let SDL initialize with no display, GPU or sound card
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+		SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+		Helper::_headless_mode = true;
+		ImageDB::setHeadless(true);
+		TextDB::setHeadless(true);
+	}
+
 	TTF_Init();
 	Input::Init();
+	if (std::filesystem::exists("resources/input.config")) {
+		InputActions::Load("resources/input.config");
+	}
 
 	int x_resolution = 640;
 	int y_resolution = 360;
@@ -63,6 +184,20 @@ int main(int argc, char* argv[]) {
 	int render_green = 255;
 	std::string game_title = "";
 	std::string initialScene;
+	int script_workers = 0;
+	//One core is left for the thread submitting the work, which helps out while it waits
+	int job_workers = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+	double fixed_tick_rate = 60.0;
+	int velocity_iterations = 8;
+	int position_iterations = 3;
+	int max_substeps = 5;
+	double hitch_budget_ms = -1.0;
+	std::string stats_overlay_font = "";
+	int stats_overlay_font_size = 14;
+	std::string stats_overlay_key = "f3";
+	bool pipelined = false;
+	double target_fps = 60.0;
+	bool vsync = true;
 
 
 
@@ -88,18 +223,79 @@ int main(int argc, char* argv[]) {
 	if (renderingExists && rendering.HasMember("clear_color_b")) {
 		render_blue = rendering["clear_color_b"].GetInt();
 	}
+	if (renderingExists && rendering.HasMember("target_fps")) {
+		target_fps = rendering["target_fps"].GetDouble();
+	}
+	if (renderingExists && rendering.HasMember("vsync")) {
+		vsync = rendering["vsync"].GetBool();
+	}
 	if (config.HasMember("game_title")) {
 		game_title = config["game_title"].GetString();
 	}
 	if (config.HasMember("initial_scene")) {
 		initialScene = config["initial_scene"].GetString();
 	}
+	if (config.HasMember("script_workers")) {
+		script_workers = config["script_workers"].GetInt();
+	}
+	if (config.HasMember("hitch_budget_ms")) {
+		hitch_budget_ms = config["hitch_budget_ms"].GetDouble();
+	}
+	if (config.HasMember("stats_overlay_font")) {
+		stats_overlay_font = config["stats_overlay_font"].GetString();
+	}
+	if (config.HasMember("stats_overlay_font_size")) {
+		stats_overlay_font_size = config["stats_overlay_font_size"].GetInt();
+	}
+	if (config.HasMember("stats_overlay_key")) {
+		stats_overlay_key = config["stats_overlay_key"].GetString();
+	}
+	if (config.HasMember("job_workers")) {
+		job_workers = config["job_workers"].GetInt();
+	}
+	if (config.HasMember("fixed_tick_rate")) {
+		fixed_tick_rate = config["fixed_tick_rate"].GetDouble();
+	}
+	if (config.HasMember("velocity_iterations")) {
+		velocity_iterations = config["velocity_iterations"].GetInt();
+	}
+	if (config.HasMember("position_iterations")) {
+		position_iterations = config["position_iterations"].GetInt();
+	}
+	if (config.HasMember("max_substeps")) {
+		max_substeps = config["max_substeps"].GetInt();
+	}
+	//Nothing is drawn headless, so there would be nothing to overlap the simulation with
+	if (config.HasMember("pipelined_rendering") && !headless) {
+		pipelined = config["pipelined_rendering"].GetBool();
+		Helper::_pipelined_mode = pipelined;
+	}
+	FramePacer::Configure(target_fps);
+	//Two frames at the target rate unless configured; autograder runs shouldn't leave logs behind
+	if (hitch_budget_ms < 0.0) {
+		hitch_budget_ms = target_fps > 0.0 ? 2000.0 / target_fps : 100.0;
+	}
+	HitchDetector::Configure(Helper::IsAutograderMode() ? 0.0 : hitch_budget_ms);
+	FixedTimestep::Configure(fixed_tick_rate, max_substeps);
+	RigidBody::configure(static_cast<float>(FixedTimestep::GetStep()), velocity_iterations, position_iterations);
 
 
-	SDL_Window* window = Helper::SDL_CreateWindow(game_title.c_str(), 50, 100, x_resolution, y_resolution, SDL_WINDOW_SHOWN);
-	SDL_Renderer* renderer = Helper::SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_ACCELERATED);
+	SDL_Window* window = nullptr;
+	SDL_Renderer* renderer = nullptr;
+	if (!headless) {
+		window = Helper::SDL_CreateWindow(game_title.c_str(), 50, 100, x_resolution, y_resolution, SDL_WINDOW_SHOWN);
+		renderer = Helper::SDL_CreateRenderer(window, -1, (vsync ? SDL_RENDERER_PRESENTVSYNC : 0) | SDL_RENDERER_ACCELERATED);
+	}
 	lua_State* lua_state = luaL_newstate();
 	luaL_openlibs(lua_state);
+	std::atexit(ShutdownEngine);
+	LuaProfiler::Init(lua_state);
+	Profiler::Init();
+	AllocTracker::Init(!bench_output.empty());
+	AllocTracker::TrackLuaState(lua_state);
+	BenchReport::Init(bench_output, lua_state, max_frames);
+	CoroutineScheduler::Init(lua_state);
+	Timers::Init(lua_state);
 	ImageDB::setWidth(x_resolution);
 	ImageDB::setHeight(y_resolution);
 
@@ -112,9 +308,14 @@ int main(int argc, char* argv[]) {
 	//Time to check the beginning images, if they exist
 
 	SceneDB sceneManager(x_resolution, y_resolution);
+	EngineStats::Init(&sceneManager, lua_state);
+	EngineStats::ConfigureOverlay(stats_overlay_font, stats_overlay_font_size, stats_overlay_key);
+	StateHash::Init(&sceneManager, lua_state);
 
-	SDL_SetRenderDrawColor(renderer, render_red, render_green, render_blue, 255);
-	SDL_RenderClear(renderer);
+	if (renderer) {
+		SDL_SetRenderDrawColor(renderer, render_red, render_green, render_blue, 255);
+		SDL_RenderClear(renderer);
+	}
 
 	bool keepLooping = true;
 	//Intro loop
@@ -122,43 +323,191 @@ int main(int argc, char* argv[]) {
 
 
 	sceneManager.loadComponents();
+	JobSystem::Init(job_workers);
+	ScriptWorkers::Init(lua_state, script_workers);
 	if (initialScene == "") {
 		std::cout << "No initial scene defined" << std::endl;
 		exit(1);
 	}
 	sceneManager.loadScene(initialScene,true);
-	while (keepLooping) {
+	FramePacer::Start();
+	HitchDetector::Start();
+	BenchReport::Start();
+	if (headless) {
+		headless_start_counter = SDL_GetPerformanceCounter();
+		headless_last_counter = headless_start_counter;
+		headless_summary = true;
+	}
+	//One frame of simulation, given that frame's input. Serially it runs on this thread between
+	//polling and presenting; pipelined, it runs on FramePipeline's thread while this one draws the frame before.
+	auto simulate_frame = [&sceneManager](const std::vector<SDL_Event>& events) {
+		PROFILE_SCOPE("Simulate");
+		{
+			PROFILE_PHASE(HitchDetector::PHASE_INPUT);
+			ALLOC_SCOPE(TAG_INPUT);
+			for (const SDL_Event& next_event : events) {
+				Input::ProcessEvent(next_event);
+			}
+			//Actions are evaluated once, as soon as this frame's input is in
+			InputActions::Update();
+		}
+
+		// Now we can do a lot of things
+		{
+			PROFILE_PHASE(HitchDetector::PHASE_START);
+			ALLOC_SCOPE(TAG_SCRIPTS);
+			sceneManager.start();
+		}
+		{
+			PROFILE_PHASE(HitchDetector::PHASE_INPUT_HOOKS);
+			ALLOC_SCOPE(TAG_SCRIPTS);
+			InputHooks::Dispatch();
+		}
+		{
+			PROFILE_PHASE(HitchDetector::PHASE_UPDATE);
+			ALLOC_SCOPE(TAG_SCRIPTS);
+			sceneManager.update();
+		}
+		{
+			PROFILE_PHASE(HitchDetector::PHASE_TIMERS);
+			ALLOC_SCOPE(TAG_SCRIPTS);
+			Timers::Dispatch();
+		}
+		{
+			PROFILE_PHASE(HitchDetector::PHASE_LATE_UPDATE);
+			ALLOC_SCOPE(TAG_SCRIPTS);
+			sceneManager.lateUpdate();
+		}
+		{
+			PROFILE_PHASE(HitchDetector::PHASE_ALTER_ACTORS);
+			ALLOC_SCOPE(TAG_SCENE);
+			sceneManager.alterActors();
+		}
+		EngineStats::EndFrame();
+		EngineStats::UpdateOverlay();
+		//This frame's draws are done; anything drawn from here on goes out with the next one
+		ImageDB::SubmitFrame();
+		//Before physics, as it always was, so collision callbacks see settled key states
+		{
+			PROFILE_PHASE(HitchDetector::PHASE_LATE_INPUT);
+			ALLOC_SCOPE(TAG_INPUT);
+			Input::LateUpdate();
+		}
+		//The simulation runs at its own fixed rate, as many ticks as this frame's time covers
+		int fixed_ticks = FixedTimestep::BeginFrame();
+		for (int tick = 0; tick < fixed_ticks; tick++) {
+			{
+				PROFILE_PHASE(HitchDetector::PHASE_FIXED_UPDATE);
+				ALLOC_SCOPE(TAG_SCRIPTS);
+				sceneManager.fixedUpdate();
+			}
+			PROFILE_PHASE(HitchDetector::PHASE_PHYSICS);
+			ALLOC_SCOPE(TAG_PHYSICS);
+			RigidBody::step();
+		}
+		RigidBody::setInterpolationAlpha(FixedTimestep::GetAlpha());
+		//Before checkForChange, so the frame that loads a scene is hashed with the scene it simulated
+		StateHash::EndFrame(Helper::GetFrameNumber());
+		PROFILE_PHASE(HitchDetector::PHASE_SCENE_CHANGE);
+		ALLOC_SCOPE(TAG_SCENE);
+		sceneManager.checkForChange();
+	};
+
+	//Render everything! The frame drawn is whichever one ImageDB::AcquireFrame() last picked up
+	auto render_frame = [&](bool last_frame) {
+		ALLOC_SCOPE(TAG_RENDER);
+		{
+			PROFILE_PHASE(HitchDetector::PHASE_RENDER);
+			SDL_SetRenderDrawColor(renderer, render_red, render_green, render_blue, 255);
+			SDL_RenderClear(renderer);
+			ImageDB::RenderAll();
+		}
+		if (last_frame) {
+			BenchReport::CaptureFinalFrame(renderer, Helper::render_frame_number);
+		}
+		PROFILE_PHASE(HitchDetector::PHASE_PRESENT);
+		Helper::SDL_RenderPresent(renderer);
+	};
 
-		bool skipFrame = false;
+	std::vector<SDL_Event> frame_events;
+	auto poll_events = [&]() {
+		PROFILE_PHASE(HitchDetector::PHASE_EVENTS);
+		ALLOC_SCOPE(TAG_INPUT);
 		SDL_Event next_event;
 		while (Helper::SDL_PollEvent(&next_event)) {
 			if (next_event.type == SDL_QUIT) {
 				keepLooping = false;
-				//Helper::SDL_RenderPresent(renderer);
-				//exit(0);
 			}
-			Input::ProcessEvent(next_event);
+			frame_events.push_back(next_event);
 		}
+	};
 
-		if (skipFrame) {
-			continue;
-		}
+	if (pipelined) {
+		FramePipeline::Start(simulate_frame);
+		//Each pass hands the simulation frame N+1 and draws frame N while it runs
+		bool frame_simulated = false;
+		while (true) {
+			if (frame_simulated) {
+				Helper::AdvancePipelinedFrame();
+				HitchDetector::EndFrame(Helper::GetFrameNumber() - 1, lua_state, sceneManager.getActorCount());
+				AllocTracker::EndFrame();
+				BenchReport::EndFrame(Helper::GetFrameNumber() - 1, sceneManager.getActorCount());
+			}
+			//Application.Quit() ends the run before its frame is shown, as it does serially
+			if (FramePipeline::QuitRequested()) {
+				break;
+			}
+			bool simulate_next = keepLooping && !(max_frames >= 0 && Helper::GetFrameNumber() >= max_frames);
+			if (!simulate_next && !frame_simulated) {
+				break;
+			}
 
+			//The simulation is idle here, so this is where the finished frame's draw lists change hands
+			ImageDB::AcquireFrame();
+			Profiler::EndFrame();
+			JobSystem::PumpMain();
+			if (simulate_next) {
+				poll_events();
+				FramePipeline::BeginFrame(frame_events);
+				frame_events.clear();
+			}
+			if (frame_simulated) {
+				render_frame(!simulate_next);
+			}
+			{
+				PROFILE_SCOPE("WaitForSimulation");
+				FramePipeline::WaitForFrame();
+			}
+			frame_simulated = simulate_next;
+		}
+		FramePipeline::Stop();
+		return 0;
+	}
 
+	while (keepLooping) {
+		if (max_frames >= 0 && Helper::GetFrameNumber() >= max_frames) {
+			break;
+		}
 
-		//Render everything!
-		SDL_SetRenderDrawColor(renderer, render_red, render_green, render_blue, 255);
-		SDL_RenderClear(renderer);
-		// Now we can do a lot of things
-		sceneManager.start();
-		sceneManager.update();
-		sceneManager.lateUpdate();
-		sceneManager.alterActors();
-		ImageDB::RenderAll();
-		Input::LateUpdate();
-		RigidBody::step();
-		sceneManager.checkForChange();
-		Helper::SDL_RenderPresent(renderer);
+		Profiler::EndFrame();
+		JobSystem::PumpMain();
+		poll_events();
+		simulate_frame(frame_events);
+		frame_events.clear();
+		if (headless) {
+			Helper::HeadlessFrameEnd();
+			Uint64 now = SDL_GetPerformanceCounter();
+			headless_min_frame = std::min(headless_min_frame, now - headless_last_counter);
+			headless_max_frame = std::max(headless_max_frame, now - headless_last_counter);
+			headless_last_counter = now;
+		}
+		else {
+			ImageDB::AcquireFrame();
+			render_frame(!keepLooping || (max_frames >= 0 && Helper::GetFrameNumber() + 1 >= max_frames));
+		}
+		HitchDetector::EndFrame(Helper::GetFrameNumber() - 1, lua_state, sceneManager.getActorCount());
+		AllocTracker::EndFrame();
+		BenchReport::EndFrame(Helper::GetFrameNumber() - 1, sceneManager.getActorCount());
 
 	}
 	return 0;
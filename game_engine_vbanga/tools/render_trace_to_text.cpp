@@ -0,0 +1,90 @@
+//Converts a binary render trace (render_trace.bin, written when RENDERLOGGER is set) into the
+//text render_logger.txt format, so traces can be diffed against test case render logs.
+//Usage: render_trace_to_text [render_trace.bin] [render_logger.txt]
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RenderTrace.h"
+
+int main(int argc, char* argv[]) {
+	std::string input_path = argc > 1 ? argv[1] : "render_trace.bin";
+	std::string output_path = argc > 2 ? argv[2] : "render_logger.txt";
+
+	std::ifstream input(input_path, std::ios::binary);
+	if (!input.is_open()) {
+		std::cerr << "error: could not open " << input_path << std::endl;
+		return 1;
+	}
+	std::vector<char> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+	RenderTrace::FileHeader header;
+	if (data.size() < sizeof(header)) {
+		std::cerr << "error: " << input_path << " is not a render trace" << std::endl;
+		return 1;
+	}
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (std::memcmp(header.magic, RenderTrace::MAGIC, sizeof(header.magic)) != 0 || header.version != RenderTrace::VERSION) {
+		std::cerr << "error: " << input_path << " is not a version " << RenderTrace::VERSION << " render trace" << std::endl;
+		return 1;
+	}
+
+	std::ofstream output(output_path);
+	if (!output.is_open()) {
+		std::cerr << "error: could not open " << output_path << " for writing" << std::endl;
+		return 1;
+	}
+
+	output << "== RENDER LOGGER ==\n";
+	output << "Study the following SDL_RenderCopyEx() calls to debug render-related issues.\n";
+	output << "Enable render logger mode on your computer by setting the RENDERLOGGER environmental variable.\n";
+	output << "frame:actor_id:actor_name\n\n";
+
+	std::unordered_map<int, std::string> actor_names;
+	size_t offset = sizeof(header);
+	size_t draws = 0;
+	while (offset + sizeof(uint32_t) <= data.size()) {
+		uint32_t tag;
+		std::memcpy(&tag, data.data() + offset, sizeof(tag));
+
+		if (tag == RenderTrace::TAG_NAME) {
+			RenderTrace::NameRecord record;
+			if (offset + sizeof(record) > data.size()) break;
+			std::memcpy(&record, data.data() + offset, sizeof(record));
+			offset += sizeof(record);
+			if (offset + record.name_length > data.size()) break;
+			actor_names[record.actor_id].assign(data.data() + offset, record.name_length);
+			offset += record.name_length;
+		}
+		else if (tag == RenderTrace::TAG_DRAW) {
+			RenderTrace::DrawRecord record;
+			if (offset + sizeof(record) > data.size()) break;
+			std::memcpy(&record, data.data() + offset, sizeof(record));
+			offset += sizeof(record);
+
+			//Same fields and formatting as the original text logger
+			output << record.frame << ":" << record.actor_id << ":" << actor_names[record.actor_id];
+			if (record.flags & RenderTrace::HAS_DSTRECT)
+				output << " dstrect " << record.dstrect[0] << " " << record.dstrect[1] << " " << record.dstrect[2] << " " << record.dstrect[3];
+
+			output << " angle " << record.angle;
+			if (record.flags & RenderTrace::HAS_CENTER)
+				output << " center " << record.center[0] << " " << record.center[1];
+
+			output << " flip " << record.flip << " renderscale " << record.scale[0] << " " << record.scale[1] << "\n";
+			draws++;
+		}
+		else {
+			std::cerr << "error: unknown record at byte " << offset << ", stopping" << std::endl;
+			break;
+		}
+	}
+
+	std::cout << "wrote " << draws << " draws to " << output_path << std::endl;
+	return 0;
+}
@@ -0,0 +1,95 @@
+//Compares two state hash logs (state_hash.bin, written when STATEHASH is set) frame by frame and
+//reports the first frame where the simulations diverged and which subsystems differ on it, so a
+//change can be checked against a known-good build replaying the same input.
+//Usage: state_hash_diff <expected state_hash.bin> <actual state_hash.bin>
+//Exits with 0 when the logs match, 2 when they diverge and 1 when a log can't be read.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "StateHash.h"
+
+static bool ReadLog(const std::string& path, std::vector<StateHash::FrameRecord>& records) {
+	std::ifstream input(path, std::ios::binary);
+	if (!input.is_open()) {
+		std::cerr << "error: could not open " << path << std::endl;
+		return false;
+	}
+	std::vector<char> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+	StateHash::FileHeader header;
+	if (data.size() < sizeof(header)) {
+		std::cerr << "error: " << path << " is not a state hash log" << std::endl;
+		return false;
+	}
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (std::memcmp(header.magic, StateHash::MAGIC, sizeof(header.magic)) != 0 || header.version != StateHash::VERSION
+		|| header.subsystem_count != StateHash::SUBSYSTEM_COUNT) {
+		std::cerr << "error: " << path << " is not a version " << StateHash::VERSION << " state hash log" << std::endl;
+		return false;
+	}
+
+	//A run that was killed can leave a partial record at the end; it's ignored
+	size_t count = (data.size() - sizeof(header)) / sizeof(StateHash::FrameRecord);
+	records.resize(count);
+	if (count > 0) {
+		std::memcpy(records.data(), data.data() + sizeof(header), count * sizeof(StateHash::FrameRecord));
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		std::cerr << "usage: state_hash_diff <expected state_hash.bin> <actual state_hash.bin>" << std::endl;
+		return 1;
+	}
+	std::vector<StateHash::FrameRecord> expected;
+	std::vector<StateHash::FrameRecord> actual;
+	if (!ReadLog(argv[1], expected) || !ReadLog(argv[2], actual)) {
+		return 1;
+	}
+
+	size_t common = std::min(expected.size(), actual.size());
+	for (size_t i = 0; i < common; i++) {
+		const StateHash::FrameRecord& a = expected[i];
+		const StateHash::FrameRecord& b = actual[i];
+		if (a.frame != b.frame) {
+			std::cout << "record " << i << ": frame " << a.frame << " in " << argv[1] << " but frame " << b.frame << " in " << argv[2] << std::endl;
+			return 2;
+		}
+
+		bool diverged = a.actors != b.actors;
+		for (int s = 0; s < StateHash::SUBSYSTEM_COUNT; s++) {
+			diverged = diverged || a.hashes[s] != b.hashes[s];
+		}
+		if (!diverged) continue;
+
+		std::cout << "first divergence at frame " << a.frame << " (" << i << " frames matched)" << std::endl;
+		if (a.actors != b.actors) {
+			std::cout << "  actor count: " << a.actors << " -> " << b.actors << std::endl;
+		}
+		//Listed in the order they're usually caused: a different actor set changes everything after it
+		for (int s = 0; s < StateHash::SUBSYSTEM_COUNT; s++) {
+			if (a.hashes[s] == b.hashes[s]) continue;
+			char line[96];
+			std::snprintf(line, sizeof(line), "  %-10s %016llx -> %016llx", StateHash::SUBSYSTEM_NAMES[s],
+				static_cast<unsigned long long>(a.hashes[s]), static_cast<unsigned long long>(b.hashes[s]));
+			std::cout << line << std::endl;
+		}
+		return 2;
+	}
+
+	if (expected.size() != actual.size()) {
+		const char* shorter = expected.size() < actual.size() ? argv[1] : argv[2];
+		std::cout << "the first " << common << " frames match, then " << shorter << " ends ("
+			<< expected.size() << " frames vs " << actual.size() << ")" << std::endl;
+		return 2;
+	}
+	std::cout << common << " frames match" << std::endl;
+	return 0;
+}